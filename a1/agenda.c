@@ -0,0 +1,221 @@
+/** @file agenda.c
+ *  @brief Implementation of agenda.h
+ *
+ */
+#include <stdlib.h>
+#include "date.h"
+#include "emalloc.h"
+#include "agenda.h"
+
+/**
+ * Function: occurs_before
+ * -----------------------
+ * @brief Checks whether the pending occurrence of one slot comes before that of another.
+ *
+ * @param agenda The agenda.
+ * @param slot1 The first slot.
+ * @param slot2 The second slot.
+ * @return int 1 if the occurrence of slot1 starts first (or at the same time, for an earlier event), 0 otherwise.
+ *
+ */
+static int occurs_before(const agenda_t *agenda, int slot1, int slot2) {
+    const agenda_slot_t *a = &agenda->slots[slot1];
+    const agenda_slot_t *b = &agenda->slots[slot2];
+
+    return a->occurrence.start < b->occurrence.start ||
+           (a->occurrence.start == b->occurrence.start && a->event < b->event);
+}
+
+/**
+ * Function: sift_down
+ * -------------------
+ * @brief Moves the slot at a position of the heap down until neither child comes before it.
+ *
+ * @param agenda The agenda.
+ * @param i The position in the heap.
+ * @return void
+ *
+ */
+static void sift_down(agenda_t *agenda, int i) {
+    int *heap = agenda->heap;
+
+    for (;;) {
+        int first = i;
+        int left = 2 * i + 1;
+        int right = left + 1;
+        if (left < agenda->size && occurs_before(agenda, heap[left], heap[first])) {
+            first = left;
+        }
+        if (right < agenda->size && occurs_before(agenda, heap[right], heap[first])) {
+            first = right;
+        }
+        if (first == i) {
+            return;
+        }
+        int slot = heap[i];
+        heap[i] = heap[first];
+        heap[first] = slot;
+        i = first;
+    }
+}
+
+/**
+ * Function: push
+ * --------------
+ * @brief Adds a slot to the heap.
+ *
+ * @param agenda The agenda.
+ * @param slot The slot.
+ * @return void
+ *
+ */
+static void push(agenda_t *agenda, int slot) {
+    int i = agenda->size++;
+
+    while (i > 0 && occurs_before(agenda, slot, agenda->heap[(i - 1) / 2])) {
+        agenda->heap[i] = agenda->heap[(i - 1) / 2];
+        i = (i - 1) / 2;
+    }
+    agenda->heap[i] = slot;
+}
+
+/**
+ * Function: agenda_create
+ * -----------------------
+ * @brief Starts listing the occurrences of the events of a table in a date range.
+ *
+ * @param table The event table; it must outlive the agenda.
+ * @param index The interval index of the table.
+ * @param from The first date of the range (YYYYMMDD).
+ * @param to The last date of the range (YYYYMMDD).
+ * @param display The time zone to list the occurrences in, or NULL to list every
+ *                occurrence on the clock of its own zone.
+ * @return agenda_t* A pointer to the new agenda.
+ *
+ */
+agenda_t *agenda_create(const event_table_t *table, const event_index_t *index, long long from, long long to,
+                        const tz_t *display) {
+    agenda_t *agenda = (agenda_t *)emalloc(sizeof(agenda_t));
+    size_t n = index->count > 0 ? index->count : 1;
+
+    agenda->table = table;
+    agenda->from = from;
+    agenda->to = to;
+    agenda->scan_from = from;
+    agenda->scan_to = to;
+    agenda->display = display != NULL && table->num_zones > 0 ? display : NULL;
+    agenda->zones = NULL;
+    if (agenda->display != NULL) {
+        agenda->scan_from = days_to_date(date_to_days(from) - AGENDA_ZONE_SLACK);
+        agenda->scan_to = days_to_date(date_to_days(to) + AGENDA_ZONE_SLACK);
+        agenda->zones = (tz_t *)emalloc(table->num_zones * sizeof(tz_t));
+        for (int i = 0; i < table->num_zones; i++) {
+            table_get_zone(table, i, &agenda->zones[i]);
+        }
+    }
+    agenda->candidates = (int *)emalloc(n * sizeof(int));
+    agenda->num_candidates = index_query(index, agenda->scan_from, agenda->scan_to, agenda->candidates);
+    agenda->next_candidate = 0;
+    agenda->slots = (agenda_slot_t *)emalloc((agenda->num_candidates > 0 ? agenda->num_candidates : 1) *
+                                             sizeof(agenda_slot_t));
+    agenda->heap = (int *)emalloc((agenda->num_candidates > 0 ? agenda->num_candidates : 1) * sizeof(int));
+    agenda->size = 0;
+    return agenda;
+}
+
+/**
+ * Function: next_kept
+ * -------------------
+ * @brief Moves a slot to the next occurrence of its event that no EXDATE cancels.
+ *
+ * With a display zone, the occurrence is converted into it, and skipped if that
+ * takes it out of the range.
+ *
+ * @param agenda The agenda.
+ * @param s The slot.
+ * @return int 1 if there was one, 0 once the occurrences of the event are exhausted.
+ *
+ */
+static int next_kept(const agenda_t *agenda, agenda_slot_t *s) {
+    while (occurrences_next(&s->iter, &s->occurrence)) {
+        if (table_is_excluded(agenda->table, s->event, s->occurrence.start)) {
+            continue;
+        }
+        if (agenda->display == NULL) {
+            return 1;
+        }
+        int zone = s->occurrence.zone;
+        if (zone >= 0 && agenda->table->zones[zone].first >= 0) {
+            const tz_t *tz = &agenda->zones[zone];
+            s->occurrence.start = tz_from_utc(agenda->display, tz_to_utc(tz, s->occurrence.start));
+            s->occurrence.end = tz_from_utc(agenda->display, tz_to_utc(tz, s->occurrence.end));
+        }
+        if (s->occurrence.start / 1000000 >= agenda->from && s->occurrence.end / 1000000 <= agenda->to) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/**
+ * Function: agenda_next
+ * ---------------------
+ * @brief Gets the next occurrence of the agenda.
+ *
+ * @param agenda The agenda.
+ * @param occurrence Set to the next occurrence; it shares the strings of its event.
+ * @return int 1 if there was another occurrence, 0 at the end of the agenda.
+ *
+ */
+int agenda_next(agenda_t *agenda, event_t *occurrence) {
+    const event_table_t *table = agenda->table;
+
+    // Let in every event that may start before the earliest pending occurrence.
+    while (agenda->next_candidate < agenda->num_candidates) {
+        int slot = agenda->next_candidate;
+        const event_t *event = &table->events[agenda->candidates[slot]];
+        long long start = event->start;
+        if (agenda->display != NULL) {
+            start = days_to_date(date_to_days(start / 1000000) - AGENDA_ZONE_SLACK) * 1000000 + start % 1000000;
+        }
+        if (agenda->size > 0 && start > agenda->slots[agenda->heap[0]].occurrence.start) {
+            break;
+        }
+        agenda_slot_t *s = &agenda->slots[slot];
+        s->event = agenda->candidates[slot];
+        occurrences_begin(&s->iter, event, event->rule >= 0 ? &table->rules[event->rule] : NULL,
+                          agenda->scan_from, agenda->scan_to);
+        if (next_kept(agenda, s)) {
+            push(agenda, slot);
+        }
+        agenda->next_candidate++;
+    }
+    if (agenda->size == 0) {
+        return 0;
+    }
+
+    agenda_slot_t *first = &agenda->slots[agenda->heap[0]];
+    *occurrence = first->occurrence;
+    if (!next_kept(agenda, first)) {
+        agenda->heap[0] = agenda->heap[--agenda->size];
+    }
+    sift_down(agenda, 0);
+    return 1;
+}
+
+/**
+ * Function: agenda_free
+ * ---------------------
+ * @brief Frees an agenda.
+ *
+ * @param agenda The agenda.
+ * @return void
+ *
+ */
+void agenda_free(agenda_t *agenda) {
+    free(agenda->zones);
+    free(agenda->candidates);
+    free(agenda->slots);
+    free(agenda->heap);
+    free(agenda);
+}
@@ -0,0 +1,64 @@
+/** @file agenda.h
+ *  @brief Function prototypes for the chronological stream of occurrences in a date range.
+ *
+ */
+#ifndef _AGENDA_H_
+#define _AGENDA_H_
+
+#include "event_index.h"
+#include "rrule.h"
+
+/**
+ * @brief The most days a time can move when converted from one zone into another
+ *        (UTC offsets range from -12:00 to +14:00).
+ */
+#define AGENDA_ZONE_SLACK 2
+
+/**
+ * @brief An event of the agenda, with the iterator over its occurrences and the
+ *        next one of them.
+ */
+typedef struct agenda_slot {
+    occurrence_iter_t iter;
+    event_t occurrence;
+    int event;
+} agenda_slot_t;
+
+/**
+ * @brief The occurrences in a date range of the events of a table, in order of
+ *        start (then of event, so ties keep the file order).
+ *
+ * The events that may have an occurrence in the range come from the index, in
+ * order of start. An event joins the min-heap `heap` (of indices into `slots`)
+ * only once the earliest pending occurrence does not start before it, so the
+ * heap holds the recurring events plus the few events that start together.
+ *
+ * With a display zone, the occurrences of the events that have a time zone are
+ * converted into it as they are generated (`zones` holds a view of each zone of
+ * the table). Since that moves them by up to a day or so either way, the index
+ * and the events are asked for the range widened by AGENDA_ZONE_SLACK days
+ * (`scan_from` to `scan_to`), the occurrences outside the range are dropped once
+ * converted, and an event is let in AGENDA_ZONE_SLACK days early.
+ */
+typedef struct agenda {
+    const event_table_t *table;
+    long long from;
+    long long to;
+    long long scan_from;
+    long long scan_to;
+    const tz_t *display;
+    tz_t *zones;
+    int *candidates;
+    int num_candidates;
+    int next_candidate;
+    agenda_slot_t *slots;
+    int *heap;
+    int size;
+} agenda_t;
+
+agenda_t *agenda_create(const event_table_t *table, const event_index_t *index, long long from, long long to,
+                        const tz_t *display);
+int agenda_next(agenda_t *agenda, event_t *occurrence);
+void agenda_free(agenda_t *agenda);
+
+#endif
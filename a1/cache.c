@@ -0,0 +1,345 @@
+/** @file cache.c
+ *  @brief Implementation of cache.h
+ *
+ * The cache of "cal.ics" is "cal.ics.cache", next to it. It starts with a
+ * header holding the key of the calendar it was built from (its path, size and
+ * modification time) and the offset and length of each section, followed by
+ * the sections themselves, each aligned to 16 bytes:
+ *
+ *     events      event_t[num_events]
+ *     rules       recurrence_t[num_rules]
+ *     exclusions  exclusion_t[exclusions_capacity]  (the hash set of EXDATEs)
+ *     zones       tz_zone_t[num_zones]        (the time zones of the events)
+ *     transitions tz_transition_t[num_transitions]
+ *     intervals   interval_t[num_events]      (the tree of event_index.h)
+ *     offsets     size_t[num_strings]         (the ids of the string pool)
+ *     text        char[text_len]              (the strings, NUL-terminated)
+ *     path        char[path_len + 1]
+ *
+ * The layout is the in-memory one, so the file is only good on the machine
+ * (and build) that wrote it; the header records the size of each record type
+ * so a cache written by another build is rejected and rebuilt. The zones looked
+ * up among the zones of the system record the modification time of their
+ * zoneinfo files (see tz_stamp()), so an update of the time zone database makes
+ * the cache stale too.
+ *
+ */
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "cache.h"
+#include "emalloc.h"
+
+/**
+ * @brief The first bytes of every cache file; the digit is bumped whenever the layout changes.
+ */
+#define CACHE_MAGIC "EVCACHE4"
+
+/**
+ * @brief The header at the start of a cache file.
+ */
+typedef struct cache_header {
+    char magic[8];
+    unsigned int record_sizes[7];
+    long long source_size;
+    long long source_mtime;
+    long long source_mtime_nsec;
+    size_t num_events;
+    size_t num_rules;
+    size_t num_exclusions;
+    size_t exclusions_capacity;
+    size_t num_zones;
+    size_t num_transitions;
+    size_t num_strings;
+    size_t text_len;
+    size_t path_len;
+    int root_level;
+    size_t offsets[9];
+    size_t size;
+} cache_header_t;
+
+/**
+ * @brief The sections of a cache file, in the order they are stored.
+ */
+enum { SECTION_EVENTS, SECTION_RULES, SECTION_EXCLUSIONS, SECTION_ZONES, SECTION_TRANSITIONS, SECTION_INTERVALS,
+       SECTION_OFFSETS, SECTION_TEXT, SECTION_PATH, NUM_SECTIONS };
+
+/**
+ * Function: cache_path
+ * --------------------
+ * @brief Gets the path of the cache file of a calendar.
+ *
+ * @param filename The path of the calendar.
+ * @return char* The path of its cache, to be freed by the caller.
+ *
+ */
+char *cache_path(const char *filename) {
+    char *path = (char *)emalloc(strlen(filename) + sizeof(".cache"));
+
+    strcpy(path, filename);
+    strcat(path, ".cache");
+    return path;
+}
+
+/**
+ * Function: fill_header
+ * ---------------------
+ * @brief Fills in the fields of a header that describe this build and a calendar file.
+ *
+ * @param header The header.
+ * @param filename The path of the calendar.
+ * @return int 1 on success, 0 if the calendar cannot be examined.
+ *
+ */
+static int fill_header(cache_header_t *header, const char *filename) {
+    struct stat st;
+
+    if (stat(filename, &st) != 0) {
+        return 0;
+    }
+    memset(header, 0, sizeof(cache_header_t));
+    memcpy(header->magic, CACHE_MAGIC, sizeof(header->magic));
+    header->record_sizes[0] = sizeof(event_t);
+    header->record_sizes[1] = sizeof(recurrence_t);
+    header->record_sizes[2] = sizeof(interval_t);
+    header->record_sizes[3] = sizeof(size_t);
+    header->record_sizes[4] = sizeof(exclusion_t);
+    header->record_sizes[5] = sizeof(tz_zone_t);
+    header->record_sizes[6] = sizeof(tz_transition_t);
+    header->source_size = st.st_size;
+    header->source_mtime = st.st_mtim.tv_sec;
+    header->source_mtime_nsec = st.st_mtim.tv_nsec;
+    header->path_len = strlen(filename);
+    return 1;
+}
+
+/**
+ * Function: layout
+ * ----------------
+ * @brief Computes the offset of every section, and the size of the file, from the counts in a header.
+ *
+ * @param header The header.
+ * @return void
+ *
+ */
+static void layout(cache_header_t *header) {
+    size_t lengths[NUM_SECTIONS];
+    size_t offset = (sizeof(cache_header_t) + 15) & ~(size_t)15;
+
+    lengths[SECTION_EVENTS] = header->num_events * sizeof(event_t);
+    lengths[SECTION_RULES] = header->num_rules * sizeof(recurrence_t);
+    lengths[SECTION_EXCLUSIONS] = header->exclusions_capacity * sizeof(exclusion_t);
+    lengths[SECTION_ZONES] = header->num_zones * sizeof(tz_zone_t);
+    lengths[SECTION_TRANSITIONS] = header->num_transitions * sizeof(tz_transition_t);
+    lengths[SECTION_INTERVALS] = header->num_events * sizeof(interval_t);
+    lengths[SECTION_OFFSETS] = header->num_strings * sizeof(size_t);
+    lengths[SECTION_TEXT] = header->text_len;
+    lengths[SECTION_PATH] = header->path_len + 1;
+    for (int i = 0; i < NUM_SECTIONS; i++) {
+        header->offsets[i] = offset;
+        offset = (offset + lengths[i] + 15) & ~(size_t)15;
+    }
+    header->size = offset;
+}
+
+/**
+ * Function: cache_open
+ * --------------------
+ * @brief Loads the cache of a calendar, if it is up to date.
+ *
+ * The cache is up to date if it was written by this build for a calendar at
+ * the same path, with the same size and modification time as the calendar now,
+ * and with the same zoneinfo files for the zones it took from the system.
+ *
+ * @param filename The path of the calendar.
+ * @return calendar_cache_t* The loaded calendar, or NULL if there is no cache, or it is stale or damaged.
+ *
+ */
+calendar_cache_t *cache_open(const char *filename) {
+    cache_header_t expected;
+    char *path = cache_path(filename);
+    int fd = open(path, O_RDONLY);
+    struct stat st;
+
+    free(path);
+    if (fd < 0) {
+        return NULL;
+    }
+    if (!fill_header(&expected, filename) || fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(cache_header_t)) {
+        close(fd);
+        return NULL;
+    }
+    void *data = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) {
+        return NULL;
+    }
+
+    // Check the key, then that the sections are where the counts say they are.
+    cache_header_t header = *(const cache_header_t *)data;
+    cache_header_t computed = header;
+    layout(&computed);
+    const char *base = (const char *)data;
+    if (memcmp(header.magic, expected.magic, sizeof(header.magic)) != 0 ||
+        memcmp(header.record_sizes, expected.record_sizes, sizeof(header.record_sizes)) != 0 ||
+        header.source_size != expected.source_size || header.source_mtime != expected.source_mtime ||
+        header.source_mtime_nsec != expected.source_mtime_nsec || header.path_len != expected.path_len ||
+        header.size != (size_t)st.st_size || memcmp(header.offsets, computed.offsets, sizeof(header.offsets)) != 0 ||
+        header.size != computed.size || memcmp(base + header.offsets[SECTION_PATH], filename, header.path_len) != 0 ||
+        (header.exclusions_capacity & (header.exclusions_capacity - 1)) != 0 ||
+        2 * header.num_exclusions > header.exclusions_capacity) {
+        munmap(data, (size_t)st.st_size);
+        return NULL;
+    }
+
+    calendar_cache_t *cache = (calendar_cache_t *)emalloc(sizeof(calendar_cache_t));
+    cache->data = data;
+    cache->size = (size_t)st.st_size;
+
+    cache->strings.text = (char *)(base + header.offsets[SECTION_TEXT]);
+    cache->strings.text_len = header.text_len;
+    cache->strings.text_capacity = header.text_len;
+    cache->strings.offsets = (size_t *)(base + header.offsets[SECTION_OFFSETS]);
+    cache->strings.count = (int)header.num_strings;
+    cache->strings.capacity = (int)header.num_strings;
+    cache->strings.slots = NULL;
+    cache->strings.num_slots = 0;
+
+    cache->table.events = (event_t *)(base + header.offsets[SECTION_EVENTS]);
+    cache->table.count = (int)header.num_events;
+    cache->table.capacity = (int)header.num_events;
+    cache->table.rules = (recurrence_t *)(base + header.offsets[SECTION_RULES]);
+    cache->table.num_rules = (int)header.num_rules;
+    cache->table.rules_capacity = (int)header.num_rules;
+    cache->table.exclusions = (exclusion_t *)(base + header.offsets[SECTION_EXCLUSIONS]);
+    cache->table.num_exclusions = (int)header.num_exclusions;
+    cache->table.exclusions_capacity = (int)header.exclusions_capacity;
+    cache->table.zones = (tz_zone_t *)(base + header.offsets[SECTION_ZONES]);
+    cache->table.num_zones = (int)header.num_zones;
+    cache->table.zones_capacity = (int)header.num_zones;
+    cache->table.transitions = (tz_transition_t *)(base + header.offsets[SECTION_TRANSITIONS]);
+    cache->table.num_transitions = (int)header.num_transitions;
+    cache->table.transitions_capacity = (int)header.num_transitions;
+    cache->table.deferred = NULL;
+    cache->table.num_deferred = 0;
+    cache->table.deferred_capacity = 0;
+    cache->table.strings = &cache->strings;
+
+    cache->index.intervals = (interval_t *)(base + header.offsets[SECTION_INTERVALS]);
+    cache->index.count = (int)header.num_events;
+    cache->index.root_level = header.root_level;
+
+    for (int i = 0; i < cache->table.num_zones; i++) {
+        const tz_zone_t *zone = &cache->table.zones[i];
+        if (zone->system && (zone->name < 0 || zone->name >= cache->strings.count ||
+                             tz_stamp(pool_get(&cache->strings, zone->name)) != zone->stamp)) {
+            cache_close(cache);
+            return NULL;
+        }
+    }
+    return cache;
+}
+
+/**
+ * Function: write_section
+ * -----------------------
+ * @brief Writes a section of a cache file at its offset.
+ *
+ * @param file The cache file, positioned at the end of the previous section.
+ * @param offset The offset of the section.
+ * @param data The contents of the section.
+ * @param len The length of the section.
+ * @return int 1 on success, 0 on a write error.
+ *
+ */
+static int write_section(FILE *file, size_t offset, const void *data, size_t len) {
+    static const char padding[16];
+    long pos = ftell(file);
+
+    if (pos < 0 || (size_t)pos > offset || fwrite(padding, 1, offset - pos, file) != offset - pos) {
+        return 0;
+    }
+    return fwrite(data, 1, len, file) == len;
+}
+
+/**
+ * Function: cache_write
+ * ---------------------
+ * @brief Writes the cache of a calendar.
+ *
+ * The cache is written to a temporary file that is then renamed over the old
+ * one, so a reader never sees a cache that is half written.
+ *
+ * @param filename The path of the calendar.
+ * @param table The events of the calendar.
+ * @param index The interval index of the table.
+ * @return int 1 on success, 0 if the cache could not be written (e.g. the directory is read-only).
+ *
+ */
+int cache_write(const char *filename, const event_table_t *table, const event_index_t *index) {
+    cache_header_t header;
+
+    if (!fill_header(&header, filename)) {
+        return 0;
+    }
+    header.num_events = table->count;
+    header.num_rules = table->num_rules;
+    header.num_exclusions = table->num_exclusions;
+    header.exclusions_capacity = table->exclusions_capacity;
+    header.num_zones = table->num_zones;
+    header.num_transitions = table->num_transitions;
+    header.num_strings = table->strings->count;
+    header.text_len = table->strings->text_len;
+    header.root_level = index->root_level;
+    layout(&header);
+
+    char *path = cache_path(filename);
+    char *temp = (char *)emalloc(strlen(path) + sizeof(".tmp"));
+    strcpy(temp, path);
+    strcat(temp, ".tmp");
+    FILE *file = fopen(temp, "wb");
+    int ok = file != NULL;
+    if (ok) {
+        ok = fwrite(&header, sizeof(header), 1, file) == 1 &&
+             write_section(file, header.offsets[SECTION_EVENTS], table->events, header.num_events * sizeof(event_t)) &&
+             write_section(file, header.offsets[SECTION_RULES], table->rules, header.num_rules * sizeof(recurrence_t)) &&
+             write_section(file, header.offsets[SECTION_EXCLUSIONS], table->exclusions,
+                           header.exclusions_capacity * sizeof(exclusion_t)) &&
+             write_section(file, header.offsets[SECTION_ZONES], table->zones, header.num_zones * sizeof(tz_zone_t)) &&
+             write_section(file, header.offsets[SECTION_TRANSITIONS], table->transitions,
+                           header.num_transitions * sizeof(tz_transition_t)) &&
+             write_section(file, header.offsets[SECTION_INTERVALS], index->intervals,
+                           header.num_events * sizeof(interval_t)) &&
+             write_section(file, header.offsets[SECTION_OFFSETS], table->strings->offsets,
+                           header.num_strings * sizeof(size_t)) &&
+             write_section(file, header.offsets[SECTION_TEXT], table->strings->text, header.text_len) &&
+             write_section(file, header.offsets[SECTION_PATH], filename, header.path_len + 1) &&
+             write_section(file, header.size, "", 0);
+        ok = fclose(file) == 0 && ok;
+        ok = ok && rename(temp, path) == 0;
+        if (!ok) {
+            remove(temp);
+        }
+    }
+    free(temp);
+    free(path);
+    return ok;
+}
+
+/**
+ * Function: cache_close
+ * ---------------------
+ * @brief Unmaps a loaded calendar and frees it.
+ *
+ * @param cache The loaded calendar.
+ * @return void
+ *
+ */
+void cache_close(calendar_cache_t *cache) {
+    munmap(cache->data, cache->size);
+    free(cache);
+}
@@ -0,0 +1,32 @@
+/** @file cache.h
+ *  @brief Function prototypes for the on-disk cache of parsed calendars.
+ *
+ */
+#ifndef _CACHE_H_
+#define _CACHE_H_
+
+#include "event_index.h"
+#include "event_table.h"
+
+/**
+ * @brief A calendar loaded from its cache file.
+ *
+ * The file is mapped into memory read-only, and `table`, `strings` and `index`
+ * point straight into it, so nothing is copied or parsed when it is opened.
+ * The table is only good for reading: nothing may be added to it, and it is
+ * released with cache_close() rather than table_free().
+ */
+typedef struct calendar_cache {
+    void *data;
+    size_t size;
+    event_table_t table;
+    string_pool_t strings;
+    event_index_t index;
+} calendar_cache_t;
+
+char *cache_path(const char *filename);
+calendar_cache_t *cache_open(const char *filename);
+int cache_write(const char *filename, const event_table_t *table, const event_index_t *index);
+void cache_close(calendar_cache_t *cache);
+
+#endif
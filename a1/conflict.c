@@ -0,0 +1,286 @@
+/** @file conflict.c
+ *  @brief Implementation of conflict.h
+ *
+ */
+#include <stdlib.h>
+#include <string.h>
+#include "conflict.h"
+#include "emalloc.h"
+
+/**
+ * Function: conflicts_create
+ * --------------------------
+ * @brief Starts a sweep over the occurrences of several calendars.
+ *
+ * @param num_calendars The number of calendars the occurrences come from.
+ * @return conflicts_t* A pointer to the new sweep.
+ *
+ */
+conflicts_t *conflicts_create(int num_calendars) {
+    conflicts_t *conflicts = (conflicts_t *)emalloc(sizeof(conflicts_t));
+    size_t n = num_calendars > 0 ? num_calendars : 1;
+
+    conflicts->names = pool_create();
+    conflicts->location_ids = (int **)emalloc(n * sizeof(int *));
+    conflicts->num_location_ids = (int *)emalloc(n * sizeof(int));
+    conflicts->num_calendars = num_calendars;
+    conflicts->calendars = (active_set_t *)emalloc(n * sizeof(active_set_t));
+    for (int i = 0; i < num_calendars; i++) {
+        conflicts->location_ids[i] = NULL;
+        conflicts->num_location_ids[i] = 0;
+        memset(&conflicts->calendars[i], 0, sizeof(active_set_t));
+    }
+    conflicts->locations = NULL;
+    conflicts->num_locations = 0;
+    conflicts->found = NULL;
+    conflicts->num_found = 0;
+    conflicts->found_capacity = 0;
+    conflicts->seq = 0;
+    return conflicts;
+}
+
+/**
+ * Function: shared_location
+ * -------------------------
+ * @brief Gets the id shared by all the calendars of the location of an occurrence.
+ *
+ * @param conflicts The sweep.
+ * @param calendar The calendar of the occurrence.
+ * @param location The id of the location in the string pool of the calendar.
+ * @param strings The string pool of the calendar.
+ * @return int The shared id of the location, or -1 if it is empty.
+ *
+ */
+static int shared_location(conflicts_t *conflicts, int calendar, int location, const string_pool_t *strings) {
+    if (location >= conflicts->num_location_ids[calendar]) {
+        int count = strings->count > location ? strings->count : location + 1;
+        int *ids = (int *)emalloc(count * sizeof(int));
+        int old = conflicts->num_location_ids[calendar];
+        if (old > 0) {
+            memcpy(ids, conflicts->location_ids[calendar], old * sizeof(int));
+        }
+        for (int i = old; i < count; i++) {
+            ids[i] = -2;
+        }
+        free(conflicts->location_ids[calendar]);
+        conflicts->location_ids[calendar] = ids;
+        conflicts->num_location_ids[calendar] = count;
+    }
+
+    int *id = &conflicts->location_ids[calendar][location];
+    if (*id == -2) {
+        const char *name = pool_get(strings, location);
+        *id = name[0] != '\0' ? pool_intern(conflicts->names, name, strlen(name)) : -1;
+    }
+    if (*id >= conflicts->num_locations) {
+        int count = 2 * conflicts->num_locations > *id ? 2 * conflicts->num_locations : *id + 1;
+        active_set_t *sets = (active_set_t *)emalloc(count * sizeof(active_set_t));
+        if (conflicts->num_locations > 0) {
+            memcpy(sets, conflicts->locations, conflicts->num_locations * sizeof(active_set_t));
+        }
+        memset(sets + conflicts->num_locations, 0, (count - conflicts->num_locations) * sizeof(active_set_t));
+        free(conflicts->locations);
+        conflicts->locations = sets;
+        conflicts->num_locations = count;
+    }
+    return *id;
+}
+
+/**
+ * Function: ends_before
+ * ---------------------
+ * @brief Checks whether an active occurrence ends before another (the order of the heap).
+ *
+ * @param a The first occurrence.
+ * @param b The second occurrence.
+ * @return int 1 if a ends first, 0 otherwise.
+ *
+ */
+static int ends_before(const conflict_t *a, const conflict_t *b) {
+    return a->occurrence.end < b->occurrence.end;
+}
+
+/**
+ * Function: set_push
+ * ------------------
+ * @brief Adds an occurrence to an active set.
+ *
+ * @param set The active set.
+ * @param entry The occurrence.
+ * @return void
+ *
+ */
+static void set_push(active_set_t *set, const conflict_t *entry) {
+    if (set->size == set->capacity) {
+        int capacity = set->capacity > 0 ? 2 * set->capacity : 4;
+        conflict_t *heap = (conflict_t *)emalloc(capacity * sizeof(conflict_t));
+        if (set->size > 0) {
+            memcpy(heap, set->heap, set->size * sizeof(conflict_t));
+        }
+        free(set->heap);
+        set->heap = heap;
+        set->capacity = capacity;
+    }
+
+    int i = set->size++;
+    while (i > 0 && ends_before(entry, &set->heap[(i - 1) / 2])) {
+        set->heap[i] = set->heap[(i - 1) / 2];
+        i = (i - 1) / 2;
+    }
+    set->heap[i] = *entry;
+}
+
+/**
+ * Function: set_expire
+ * --------------------
+ * @brief Removes the occurrences that end at or before a given time from an active set.
+ *
+ * @param set The active set.
+ * @param start The time the sweep line has reached (YYYYMMDDhhmmss).
+ * @return void
+ *
+ */
+static void set_expire(active_set_t *set, long long start) {
+    while (set->size > 0 && set->heap[0].occurrence.end <= start) {
+        conflict_t last = set->heap[--set->size];
+        int i = 0;
+        for (;;) {
+            int first = 2 * i + 1;
+            if (first >= set->size) {
+                break;
+            }
+            if (first + 1 < set->size && ends_before(&set->heap[first + 1], &set->heap[first])) {
+                first++;
+            }
+            if (!ends_before(&set->heap[first], &last)) {
+                break;
+            }
+            set->heap[i] = set->heap[first];
+            i = first;
+        }
+        set->heap[i] = last;
+    }
+}
+
+/**
+ * Function: add_found
+ * -------------------
+ * @brief Records a conflict of the occurrence being added.
+ *
+ * @param conflicts The sweep.
+ * @param entry The earlier occurrence it overlaps.
+ * @param reason Why they conflict.
+ * @return void
+ *
+ */
+static void add_found(conflicts_t *conflicts, const conflict_t *entry, conflict_reason_t reason) {
+    if (conflicts->num_found == conflicts->found_capacity) {
+        int capacity = conflicts->found_capacity > 0 ? 2 * conflicts->found_capacity : 16;
+        conflict_t *found = (conflict_t *)emalloc(capacity * sizeof(conflict_t));
+        if (conflicts->num_found > 0) {
+            memcpy(found, conflicts->found, conflicts->num_found * sizeof(conflict_t));
+        }
+        free(conflicts->found);
+        conflicts->found = found;
+        conflicts->found_capacity = capacity;
+    }
+    conflicts->found[conflicts->num_found] = *entry;
+    conflicts->found[conflicts->num_found++].reason = reason;
+}
+
+/**
+ * Function: compare_seq
+ * ---------------------
+ * @brief Orders conflicts by their place in the stream (for qsort()).
+ *
+ * @param a The first conflict.
+ * @param b The second conflict.
+ * @return int A negative, zero or positive number as a comes before, with or after b.
+ *
+ */
+static int compare_seq(const void *a, const void *b) {
+    long seq1 = ((const conflict_t *)a)->seq;
+    long seq2 = ((const conflict_t *)b)->seq;
+
+    return seq1 < seq2 ? -1 : seq1 > seq2;
+}
+
+/**
+ * Function: conflicts_add
+ * -----------------------
+ * @brief Moves the sweep line to the start of the next occurrence and finds what it overlaps.
+ *
+ * The occurrences must be added in order of start. The ones that end at or before the
+ * start of the new occurrence are dropped from the active sets of its location and
+ * calendar; whatever is left in them started no later and ends after it starts, so
+ * it overlaps the new occurrence. So each occurrence is pushed and popped once, and
+ * only the active sets of its own location and calendar are looked at: O(n log n)
+ * overall, plus the conflicts found. Two occurrences of the same calendar and location
+ * are only reported once, as CONFLICT_LOCATION.
+ *
+ * @param conflicts The sweep.
+ * @param occurrence The occurrence.
+ * @param calendar The calendar it comes from.
+ * @param strings The string pool of the calendar.
+ * @return int The number of conflicts, left in `found` in the order the occurrences
+ *             were added.
+ *
+ */
+int conflicts_add(conflicts_t *conflicts, const event_t *occurrence, int calendar, const string_pool_t *strings) {
+    conflict_t entry;
+
+    entry.occurrence = *occurrence;
+    entry.calendar = calendar;
+    entry.location = shared_location(conflicts, calendar, occurrence->location, strings);
+    entry.seq = conflicts->seq++;
+    entry.reason = CONFLICT_LOCATION;
+    conflicts->num_found = 0;
+
+    if (entry.location >= 0) {
+        active_set_t *set = &conflicts->locations[entry.location];
+        set_expire(set, occurrence->start);
+        for (int i = 0; i < set->size; i++) {
+            add_found(conflicts, &set->heap[i], CONFLICT_LOCATION);
+        }
+        set_push(set, &entry);
+    }
+    active_set_t *set = &conflicts->calendars[calendar];
+    set_expire(set, occurrence->start);
+    for (int i = 0; i < set->size; i++) {
+        if (entry.location < 0 || set->heap[i].location != entry.location) {
+            add_found(conflicts, &set->heap[i], CONFLICT_CALENDAR);
+        }
+    }
+    set_push(set, &entry);
+
+    if (conflicts->num_found > 1) {
+        qsort(conflicts->found, conflicts->num_found, sizeof(conflict_t), compare_seq);
+    }
+    return conflicts->num_found;
+}
+
+/**
+ * Function: conflicts_free
+ * ------------------------
+ * @brief Frees a sweep and its active sets.
+ *
+ * @param conflicts The sweep.
+ * @return void
+ *
+ */
+void conflicts_free(conflicts_t *conflicts) {
+    for (int i = 0; i < conflicts->num_calendars; i++) {
+        free(conflicts->location_ids[i]);
+        free(conflicts->calendars[i].heap);
+    }
+    for (int i = 0; i < conflicts->num_locations; i++) {
+        free(conflicts->locations[i].heap);
+    }
+    free(conflicts->location_ids);
+    free(conflicts->num_location_ids);
+    free(conflicts->calendars);
+    free(conflicts->locations);
+    free(conflicts->found);
+    pool_free(conflicts->names);
+    free(conflicts);
+}
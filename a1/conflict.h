@@ -0,0 +1,68 @@
+/** @file conflict.h
+ *  @brief Function prototypes for finding overlapping occurrences with a sweep line.
+ *
+ */
+#ifndef _CONFLICT_H_
+#define _CONFLICT_H_
+
+#include "event_table.h"
+
+/**
+ * @brief Why two occurrences conflict: they overlap in the same (non-empty) LOCATION,
+ *        or they overlap in the same calendar, i.e. for the person whose it is.
+ */
+typedef enum conflict_reason {
+    CONFLICT_LOCATION,
+    CONFLICT_CALENDAR
+} conflict_reason_t;
+
+/**
+ * @brief An occurrence seen by the sweep: the calendar it is from, its location as
+ *        an id shared by all the calendars (-1 if it has none), and its place in the
+ *        stream (`seq`). As a conflict, `reason` tells why it overlaps the new one.
+ */
+typedef struct conflict {
+    event_t occurrence;
+    int calendar;
+    int location;
+    long seq;
+    conflict_reason_t reason;
+} conflict_t;
+
+/**
+ * @brief The occurrences that have not ended yet at the sweep line, in a min-heap by end.
+ */
+typedef struct active_set {
+    conflict_t *heap;
+    int size;
+    int capacity;
+} active_set_t;
+
+/**
+ * @brief A sweep over a stream of occurrences sorted by start, finding the earlier
+ *        occurrences each new one overlaps.
+ *
+ * There is an active set per location and one per calendar. `names` interns the
+ * locations of all the calendars, and `location_ids[c]` maps the location ids of
+ * calendar c to the ids in `names` (-1 until the location is first met). `found`
+ * holds the conflicts of the last occurrence added.
+ */
+typedef struct conflicts {
+    string_pool_t *names;
+    int **location_ids;
+    int *num_location_ids;
+    int num_calendars;
+    active_set_t *locations;
+    int num_locations;
+    active_set_t *calendars;
+    conflict_t *found;
+    int num_found;
+    int found_capacity;
+    long seq;
+} conflicts_t;
+
+conflicts_t *conflicts_create(int num_calendars);
+int conflicts_add(conflicts_t *conflicts, const event_t *occurrence, int calendar, const string_pool_t *strings);
+void conflicts_free(conflicts_t *conflicts);
+
+#endif
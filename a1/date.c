@@ -0,0 +1,116 @@
+/** @file date.c
+ *  @brief Implementation of date.h
+ *
+ * Dates are converted to and from day numbers (the number of days since
+ * 1970-01-01 in the proleptic Gregorian calendar) with the branch-light
+ * algorithms of Howard Hinnant's "chrono-Compatible Low-Level Date
+ * Algorithms", so adding days never needs month-length tables.
+ *
+ */
+#include "date.h"
+
+/**
+ * Function: days_from_civil
+ * -------------------------
+ * @brief Converts a calendar date into a day number.
+ *
+ * @param year The year.
+ * @param month The month, from 1 to 12.
+ * @param day The day of the month, from 1 to 31.
+ * @return long The number of days since 1970-01-01 (negative before it).
+ *
+ */
+long days_from_civil(int year, int month, int day) {
+    long y = year - (month <= 2);
+    long era = (y >= 0 ? y : y - 399) / 400;
+    long yoe = y - era * 400;
+    long doy = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+    long doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+
+    return era * 146097 + doe - 719468;
+}
+
+/**
+ * Function: civil_from_days
+ * -------------------------
+ * @brief Converts a day number into a calendar date.
+ *
+ * @param days The number of days since 1970-01-01.
+ * @param year Set to the year.
+ * @param month Set to the month, from 1 to 12.
+ * @param day Set to the day of the month, from 1 to 31.
+ * @return void
+ *
+ */
+void civil_from_days(long days, int *year, int *month, int *day) {
+    long z = days + 719468;
+    long era = (z >= 0 ? z : z - 146096) / 146097;
+    long doe = z - era * 146097;
+    long yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    long doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    long mp = (5 * doy + 2) / 153;
+
+    *day = (int)(doy - (153 * mp + 2) / 5 + 1);
+    *month = (int)(mp < 10 ? mp + 3 : mp - 9);
+    *year = (int)(yoe + era * 400 + (*month <= 2));
+}
+
+/**
+ * Function: date_to_days
+ * ----------------------
+ * @brief Converts a date of the form YYYYMMDD into a day number.
+ *
+ * @param date The date, e.g. 20230601.
+ * @return long The number of days since 1970-01-01.
+ *
+ */
+long date_to_days(long long date) {
+    return days_from_civil((int)(date / 10000), (int)(date / 100 % 100), (int)(date % 100));
+}
+
+/**
+ * Function: days_to_date
+ * ----------------------
+ * @brief Converts a day number into a date of the form YYYYMMDD.
+ *
+ * @param days The number of days since 1970-01-01.
+ * @return long long The date, e.g. 20230601.
+ *
+ */
+long long days_to_date(long days) {
+    int year, month, day;
+
+    civil_from_days(days, &year, &month, &day);
+    return year * 10000LL + month * 100 + day;
+}
+
+/**
+ * Function: timestamp_to_seconds
+ * ------------------------------
+ * @brief Converts a timestamp into a number of seconds.
+ *
+ * @param timestamp The timestamp (YYYYMMDDhhmmss).
+ * @return long long The number of seconds since 1970-01-01 00:00:00 (a Unix time, for a time in UTC).
+ *
+ */
+long long timestamp_to_seconds(long long timestamp) {
+    long long time = timestamp % 1000000;
+
+    return date_to_days(timestamp / 1000000) * 86400LL + time / 10000 * 3600 + time / 100 % 100 * 60 + time % 100;
+}
+
+/**
+ * Function: seconds_to_timestamp
+ * ------------------------------
+ * @brief Converts a number of seconds back into a timestamp (see timestamp_to_seconds()).
+ *
+ * @param seconds The number of seconds since 1970-01-01 00:00:00.
+ * @return long long The timestamp (YYYYMMDDhhmmss).
+ *
+ */
+long long seconds_to_timestamp(long long seconds) {
+    long long days = seconds >= 0 ? seconds / 86400 : -((-seconds + 86399) / 86400);
+    long long time = seconds - days * 86400;
+
+    return days_to_date((long)days) * 1000000 + time / 3600 * 10000 + time / 60 % 60 * 100 + time % 60;
+}
@@ -0,0 +1,15 @@
+/** @file date.h
+ *  @brief Function prototypes for the calendar date arithmetic.
+ *
+ */
+#ifndef _DATE_H_
+#define _DATE_H_
+
+long days_from_civil(int year, int month, int day);
+void civil_from_days(long days, int *year, int *month, int *day);
+long date_to_days(long long date);
+long long days_to_date(long days);
+long long timestamp_to_seconds(long long timestamp);
+long long seconds_to_timestamp(long long seconds);
+
+#endif
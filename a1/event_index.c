@@ -0,0 +1,238 @@
+/** @file event_index.c
+ *  @brief Implementation of event_index.h
+ *
+ * The implicit tree follows the layout of Heng Li's cgranges: for n intervals
+ * sorted by start, the node at position i has level k when its k lowest bits are
+ * set, its children are at i - 2^(k-1) and i + 2^(k-1), and the root is at
+ * 2^K - 1 for the largest K with 2^K <= n. A query walks the tree top down,
+ * skipping every subtree whose `max_end` is before the range, so it visits
+ * O(log n + k) nodes for k results.
+ *
+ */
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+#include "date.h"
+#include "emalloc.h"
+#include "event_index.h"
+#include "rrule.h"
+
+/**
+ * Function: sort_intervals
+ * ------------------------
+ * @brief Sorts intervals by start with an LSD radix sort, 16 bits at a time.
+ *
+ * A timestamp is below 10^14 < 2^48, so three passes suffice, and a pass whose
+ * digit is the same for every interval is skipped. The sort is stable, so the
+ * intervals of equal start keep the order they are given in (that of the events).
+ *
+ * @param intervals The intervals.
+ * @param n The number of intervals.
+ * @return void
+ *
+ */
+static void sort_intervals(interval_t *intervals, int n) {
+    interval_t *buffer = (interval_t *)emalloc(n * sizeof(interval_t));
+    size_t *counts = (size_t *)emalloc(65536 * sizeof(size_t));
+    interval_t *from = intervals;
+    interval_t *to = buffer;
+
+    for (int shift = 0; shift < 48; shift += 16) {
+        memset(counts, 0, 65536 * sizeof(size_t));
+        for (int i = 0; i < n; i++) {
+            counts[(unsigned long long)from[i].start >> shift & 0xffff]++;
+        }
+        if (counts[(unsigned long long)from[0].start >> shift & 0xffff] == (size_t)n) {
+            continue;
+        }
+        size_t offset = 0;
+        for (int digit = 0; digit < 65536; digit++) {
+            size_t count = counts[digit];
+            counts[digit] = offset;
+            offset += count;
+        }
+        for (int i = 0; i < n; i++) {
+            to[counts[(unsigned long long)from[i].start >> shift & 0xffff]++] = from[i];
+        }
+        interval_t *swap = from;
+        from = to;
+        to = swap;
+    }
+    if (from != intervals) {
+        memcpy(intervals, from, n * sizeof(interval_t));
+    }
+    free(counts);
+    free(buffer);
+}
+
+/**
+ * Function: span_end
+ * ------------------
+ * @brief Gets a bound on the end of the last occurrence of an event.
+ *
+ * @param event The event.
+ * @param rule How the event repeats, or NULL if it does not.
+ * @return long long A timestamp no earlier than the end of any occurrence, or LLONG_MAX.
+ *
+ */
+static long long span_end(const event_t *event, const recurrence_t *rule) {
+    long long end = event->end > event->start ? event->end : event->start;
+
+    if (rule == NULL) {
+        return end;
+    }
+    if (rule->count != 0) {
+        event_t last;
+        if (rrule_nth(event, rule, rule->count - 1, &last)) {
+            return last.end > end ? last.end : end;
+        }
+        return end;
+    }
+    if (rule->until != 0) {
+        long length = date_to_days(event->end / 1000000) - date_to_days(event->start / 1000000);
+        long long last = days_to_date(date_to_days(rule->until / 1000000) + (length > 0 ? length : 0)) * 1000000 + 235959;
+        return last > end ? last : end;
+    }
+    return LLONG_MAX;
+}
+
+/**
+ * Function: index_create
+ * ----------------------
+ * @brief Builds the interval index of the events of a table.
+ *
+ * @param table The event table.
+ * @return event_index_t* A pointer to the new index.
+ *
+ */
+event_index_t *index_create(const event_table_t *table) {
+    event_index_t *index = (event_index_t *)emalloc(sizeof(event_index_t));
+    int n = table->count;
+
+    index->count = n;
+    index->intervals = (interval_t *)emalloc((n > 0 ? n : 1) * sizeof(interval_t));
+    for (int i = 0; i < n; i++) {
+        const event_t *event = &table->events[i];
+        interval_t *interval = &index->intervals[i];
+        interval->start = event->start;
+        interval->end = span_end(event, event->rule >= 0 ? &table->rules[event->rule] : NULL);
+        interval->event = i;
+    }
+    if (n > 0) {
+        sort_intervals(index->intervals, n);
+    }
+
+    // Fill in `max_end` bottom up. `last` is the rightmost node of the level being
+    // built; a node missing its right child (past the end of the array) takes the
+    // `max_end` of `last` in its place.
+    interval_t *a = index->intervals;
+    long last = 0;
+    long long lastMax = 0;
+    int k;
+    index->root_level = -1;
+    if (n == 0) {
+        return index;
+    }
+    for (long i = 0; i < n; i += 2) {
+        last = i;
+        lastMax = a[i].max_end = a[i].end;
+    }
+    for (k = 1; 1L << k <= n; k++) {
+        long half = 1L << (k - 1);
+        for (long i = (half << 1) - 1; i < n; i += half << 2) {
+            long long left = a[i - half].max_end;
+            long long right = i + half < n ? a[i + half].max_end : lastMax;
+            long long max = a[i].end;
+            max = left > max ? left : max;
+            max = right > max ? right : max;
+            a[i].max_end = max;
+        }
+        last = (last >> k) & 1 ? last - half : last + half;
+        if (last < n && a[last].max_end > lastMax) {
+            lastMax = a[last].max_end;
+        }
+    }
+    index->root_level = k - 1;
+    return index;
+}
+
+/**
+ * Function: index_query
+ * ---------------------
+ * @brief Finds the events that may have an occurrence in a date range.
+ *
+ * These are the events whose span overlaps the range; a recurring event among
+ * them still has to be expanded to find its occurrences in the range.
+ *
+ * @param index The index.
+ * @param from The first date of the range (YYYYMMDD).
+ * @param to The last date of the range (YYYYMMDD).
+ * @param events The array to store the events in; it must hold index->count events.
+ * @return int The number of events stored, in order of start (then of event).
+ *
+ */
+int index_query(const event_index_t *index, long long from, long long to, int *events) {
+    const interval_t *a = index->intervals;
+    long long lo = from * 1000000;
+    long long hi = to * 1000000 + 999999;
+    long n = index->count;
+    int count = 0;
+    int top = 0;
+    struct {
+        long node;
+        int level;
+        int left_done;
+    } stack[64];
+
+    if (n == 0) {
+        return 0;
+    }
+    stack[top].node = (1L << index->root_level) - 1;
+    stack[top].level = index->root_level;
+    stack[top++].left_done = 0;
+    while (top > 0) {
+        long node = stack[--top].node;
+        int level = stack[top].level;
+        if (level <= 3) {
+            // A small subtree: scan it in order.
+            long first = node >> level << level;
+            long end = first + (1L << (level + 1)) - 1;
+            for (long i = first; i < end && i < n && a[i].start <= hi; i++) {
+                if (a[i].end >= lo) {
+                    events[count++] = a[i].event;
+                }
+            }
+        } else if (!stack[top].left_done) {
+            long left = node - (1L << (level - 1));
+            stack[top++].left_done = 1;
+            // A left child past the end of the array still has children in it.
+            if (left >= n || a[left].max_end >= lo) {
+                stack[top].node = left;
+                stack[top].level = level - 1;
+                stack[top++].left_done = 0;
+            }
+        } else if (node < n && a[node].start <= hi) {
+            if (a[node].end >= lo) {
+                events[count++] = a[node].event;
+            }
+            stack[top].node = node + (1L << (level - 1));
+            stack[top].level = level - 1;
+            stack[top++].left_done = 0;
+        }
+    }
+    return count;
+}
+
+/**
+ * Function: index_free
+ * --------------------
+ * @brief Frees an interval index.
+ *
+ * @param index The index.
+ * @return void
+ *
+ */
+void index_free(event_index_t *index) {
+    free(index->intervals);
+    free(index);
+}
@@ -0,0 +1,42 @@
+/** @file event_index.h
+ *  @brief Function prototypes for the interval index over the events of a table.
+ *
+ */
+#ifndef _EVENT_INDEX_H_
+#define _EVENT_INDEX_H_
+
+#include "event_table.h"
+
+/**
+ * @brief The span of an event, from the start of its first occurrence to the end
+ *        of its last one (LLONG_MAX if it repeats forever), as a tree node.
+ *
+ * `max_end` is the largest `end` in the subtree rooted at this node.
+ */
+typedef struct interval {
+    long long start;
+    long long end;
+    long long max_end;
+    int event;
+} interval_t;
+
+/**
+ * @brief An interval tree over the spans of the events of a table.
+ *
+ * The spans are sorted by start (then by event, so ties keep the file order) and
+ * the tree is implicit in that array: the leaves are the even positions, and the
+ * node at level k, with its k lowest bits set, covers the 2^(k+1) - 1 positions
+ * around it. Only `max_end` has to be stored, which makes building the tree a
+ * sort plus one linear pass.
+ */
+typedef struct event_index {
+    interval_t *intervals;
+    int count;
+    int root_level;
+} event_index_t;
+
+event_index_t *index_create(const event_table_t *table);
+int index_query(const event_index_t *index, long long from, long long to, int *events);
+void index_free(event_index_t *index);
+
+#endif
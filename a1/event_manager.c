@@ -11,6 +11,17 @@
 #include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
+#include <unistd.h>
+#include "agenda.h"
+#include "cache.h"
+#include "conflict.h"
+#include "emalloc.h"
+#include "event_index.h"
+#include "event_table.h"
+#include "ics_parse.h"
+#include "merge.h"
+#include "output.h"
+#include "tz.h"
 
 /**
  * @brief The maximum line length.
@@ -18,25 +29,103 @@
  */
 #define MAX_LINE_LEN 132
 
+/**
+ * @brief A calendar given with --file: its events and their interval index, either
+ *        parsed from the file or loaded from its cache (then `cache` is not NULL).
+ *
+ */
+typedef struct calendar {
+    event_table_t *table;
+    event_index_t *index;
+    calendar_cache_t *cache;
+} calendar_t;
+
+/**
+ * @brief What to print for the occurrences in a date range: each of them (the agenda),
+ *        only the blocks of time they keep busy (--freebusy), or only the ones that
+ *        overlap an earlier one, with what they overlap (--conflicts).
+ *
+ */
+typedef enum view {
+    VIEW_AGENDA,
+    VIEW_FREEBUSY,
+    VIEW_CONFLICTS
+} view_t;
+
+/**
+ * @brief The options given on the command line (see main()).
+ *
+ */
+typedef struct options {
+    const char *start;
+    const char *end;
+    const char *windowsFile;
+    const char *zone;
+    int useCache;
+    int threads;
+    view_t view;
+} options_t;
+
+/**
+ * @brief A date range to print the events of, and where to print them. In batch
+ *        mode `out` keeps the output of the window in memory until every window
+ *        is done. `preDate` and `first` track the date lines printed so far. In the
+ *        free/busy view, `busyStart` and `busyEnd` hold the busy block being
+ *        coalesced (`busyEnd` is -1 when there is none). In the conflicts view,
+ *        `conflicts` is the sweep over the occurrences of the window.
+ *
+ */
+typedef struct window {
+    long long from;
+    long long to;
+    char start[32];
+    char end[32];
+    view_t view;
+    output_t *out;
+    long long preDate;
+    int first;
+    long long busyStart;
+    long long busyEnd;
+    conflicts_t *conflicts;
+} window_t;
+
 /** prototype*/
-void format(char *date);
-int ics_read(FILE *ics, char ics_detail[][4][1024]);
-void inputRead(char *argv[]);
-void process(char info[][100], char ics_detail[][4][1024], int numEvents);
-int timeCheck(const char *date1, const char *date2, const char *word);
-int convertTime(int hour);
-void printout(char *dateDetail[], int *timeDetail[], int check);
-const char *getAMPM(int hour);
-void getUntilDate(const char* rruleLine, char* untilDate);
-void addDaysToPreStartDate(char *preStartDate);
-int compareDates(const char* preStartDate, const char* untilDate);
-void getNextBufferInfo(FILE *ics, char position[], char summary[]);
+long long parseDate(const char *date);
+void inputRead(const options_t *options, const tz_t *display, char *files[], int numFiles);
+int loadDisplayZone(const char *name, tz_t *display);
+window_t *readWindows(const char *path, int *numWindows);
+void loadCalendar(const char *filename, int useCache, int threads, calendar_t *calendar);
+void freeCalendar(calendar_t *calendar);
+void process(long long startDate, long long endDate, view_t view, const tz_t *display, calendar_t *calendars,
+             int numCalendars);
+void processBatch(window_t *windows, int numWindows, view_t view, const tz_t *display, calendar_t *calendars,
+                  int numCalendars);
+int compareWindows(const void *a, const void *b);
+void openWindow(window_t *window, view_t view, int numCalendars, output_t *out);
+void emit(window_t *window, const event_t *occurrence, int calendar, const calendar_t *calendars);
+int startDay(window_t *window, long long date);
+void flushBusy(window_t *window);
+void finishWindow(window_t *window);
+void printout(output_t *out, const event_t *event, const string_pool_t *strings, int check);
 
 /**
  * Function: main
  * --------------
  * @brief The main function and entry point of the program.
  *
+ * The arguments are --start=yyyy/mm/dd, --end=yyyy/mm/dd and one or more
+ * --file=FILE, in any order, plus --cache to use the calendar caches. Instead
+ * of --start and --end, --windows=FILE (or --windows=- for the standard input)
+ * reads a list of date ranges to answer in one go (see readWindows()). Large
+ * files are read by as many threads as there are processors, or by N threads
+ * with --threads=N. With --freebusy, only the blocks of time the events keep
+ * busy are printed, overlapping events being merged into one block. With
+ * --conflicts, only the events that overlap an earlier one in the same location
+ * or in the same calendar are printed, each followed by the ones it overlaps.
+ * Events with a time zone (a TZID, or a time in UTC) are printed on the clock of
+ * the zone given with --tz=ZONE (e.g. --tz=America/Vancouver), or else of the
+ * local time zone (see loadDisplayZone()); floating times are printed as they are.
+ *
  * @param argc The number of arguments passed to the program.
  * @param argv The list of arguments passed to the program.
  * @return int 0: No errors; 1: Errors produced.
@@ -44,381 +133,521 @@ void getNextBufferInfo(FILE *ics, char position[], char summary[]);
  */
 int main(int argc, char *argv[])
 {
-    if(argc != 4){
+    options_t options = {NULL, NULL, NULL, NULL, 0, (int)sysconf(_SC_NPROCESSORS_ONLN), VIEW_AGENDA};
+    char **files = (char **)emalloc(argc * sizeof(char *)); int numFiles = 0;
+    for (int i = 1; i < argc; i++) {
+        if (strncmp(argv[i], "--start=", 8) == 0) {options.start = argv[i] + 8;}
+        else if (strncmp(argv[i], "--end=", 6) == 0) {options.end = argv[i] + 6;}
+        else if (strncmp(argv[i], "--file=", 7) == 0) {files[numFiles++] = argv[i] + 7;}
+        else if (strncmp(argv[i], "--windows=", 10) == 0) {options.windowsFile = argv[i] + 10;}
+        else if (strncmp(argv[i], "--threads=", 10) == 0) {options.threads = atoi(argv[i] + 10);}
+        else if (strncmp(argv[i], "--tz=", 5) == 0) {options.zone = argv[i] + 5;}
+        else if (strcmp(argv[i], "--cache") == 0) {options.useCache = 1;}
+        else if (strcmp(argv[i], "--freebusy") == 0) {options.view = VIEW_FREEBUSY;}
+        else if (strcmp(argv[i], "--conflicts") == 0) {options.view = VIEW_CONFLICTS;}
+        else {numFiles = 0; break;}
+    }
+    if((options.windowsFile == NULL ? options.start == NULL || options.end == NULL
+                                    : options.start != NULL || options.end != NULL) || numFiles == 0){
+        free(files);
+        return 1;
+    }
+    if (options.threads < 1) {options.threads = 1;}
+    tz_t display;
+    if (!loadDisplayZone(options.zone, &display)) {
+        fprintf(stderr, "unknown time zone %s\n", options.zone);
+        free(files);
         return 1;
     }
-    inputRead(argv);
-    // TODO: your code.
+    inputRead(&options, &display, files, numFiles);
+    tz_free(&display);
+    free(files);
     return 0;
 }
 
 /**
  * Function: inputRead
  * -------------------
- * @brief Reads and processes the input arguments and file.
- *
- * This function reads the command-line arguments and the input file specified in the arguments.
- * It processes the information and calls the necessary functions to perform the desired operations.
- *
- * @param argv The list of command-line arguments passed to the program.
+ * @brief Reads the input files and prints the events that fall within the date range.
+ *
+ * This function reads every calendar given on the command line and prints the events
+ * of all of them that fall between the start and end dates, merged into one agenda.
+ * In batch mode, the calendars are read once and every window is answered from them.
+ *
+ * @param options The options given on the command line: the start and end dates (or
+ *                the file listing the windows in batch mode), and how to read and
+ *                print the calendars.
+ * @param display The time zone to print the events in.
+ * @param files The paths of the calendars.
+ * @param numFiles The number of calendars.
  * @return void
  *
  */
-void inputRead(char *argv[]) {
-    char info[3][100];
-    char ics_detail[50][4][1024];
-    for (int i = 1; i <= 2; i++) {
-        char *token = strtok(argv[i], "=");
-        token = strtok(NULL, "=");
-        format(token);
-        strcpy(info[i - 1], token);
+void inputRead(const options_t *options, const tz_t *display, char *files[], int numFiles) {
+    int numWindows = 0;
+    window_t *windows = options->windowsFile != NULL ? readWindows(options->windowsFile, &numWindows) : NULL;
+    calendar_t *calendars = (calendar_t *)emalloc(numFiles * sizeof(calendar_t));
+    for (int i = 0; i < numFiles; i++) {
+        loadCalendar(files[i], options->useCache, options->threads, &calendars[i]);
     }
-    char *token = strtok(argv[3], "=");
-    token = strtok(NULL, "=");
-    strcpy(info[2], token);
-    FILE *ics = fopen(info[2], "r");
-    int numEvents = ics_read(ics, ics_detail);
-
-    process(info, ics_detail, numEvents);
 
-    fclose(ics);
-}
+    if (windows != NULL) {
+        processBatch(windows, numWindows, options->view, display, calendars, numFiles);
+        free(windows);
+    } else {
+        process(parseDate(options->start), parseDate(options->end), options->view, display, calendars, numFiles);
+    }
 
-/**
- * Function: format
- * ----------------
- * @brief Formats the date string in a specific format.
- *
- * This function takes a date string in the format "yyyy/mm/dd" and converts it into
- * the format "yyyymmdd" by removing the slashes (/) and padding the year, month, and day
- * with leading zeros if necessary. For example: format("2020/1/1") returns "20200101".
- *
- * @param date The date string to be formatted.
- * @return void
- *
- */
-void format(char *date) {
-    int year, month, day;
-    sscanf(date, "%d/%d/%d", &year, &month, &day);
-    sprintf(date, "%04d%02d%02d", year, month, day);
+    for (int i = 0; i < numFiles; i++) {
+        freeCalendar(&calendars[i]);
+    }
+    free(calendars);
 }
 
 /**
- * Function: ics_read
- * ------------------
- * @brief Reads the content of the ICS file and extracts event details.
+ * Function: loadDisplayZone
+ * -------------------------
+ * @brief Compiles the time zone the events are printed in.
  *
- * This function reads the content of the provided ICS file line by line and extracts
- * the event details such as start date, end date, location, and summary. It stores
- * the extracted details in the ics_detail array.
+ * That is the zone given with --tz, or else the one the TZ environment variable
+ * names, or else the one of the system (/etc/localtime), or else UTC. The zone is
+ * compiled once (see tz.h), so converting an occurrence never calls localtime().
  *
- * @param ics The file pointer to the ICS file.
- * @param ics_detail The array to store the extracted event details.
- * @return int The number of events extracted from the ICS file.
+ * @param name The zone given with --tz, or NULL.
+ * @param display Set to the zone, to be freed with tz_free().
+ * @return int 1 on success, 0 if the zone given with --tz is not known.
  *
  */
-int ics_read(FILE *ics, char ics_detail[][4][1024]) {
-    char buffer[81]; char untilDate[16];  char preStartDate[16]; char preEndDate[16]; int count = 0;  int numEvents = 0; // Initialize the number of events to 0
-    char summary[48]; char position[48];
-    while (fgets(buffer, sizeof(buffer), ics) != NULL) {
-        if (strstr(buffer, "DTSTART") != NULL) {
-            count = 1; numEvents++;
-        } else if (strstr(buffer,"DTEND") != NULL){count = 2;}
-        if (strstr(buffer, "RRULE") != NULL){
-            getUntilDate(buffer, untilDate); addDaysToPreStartDate(preStartDate); addDaysToPreStartDate(preEndDate); count = 0;
-            getNextBufferInfo(ics, ics_detail[numEvents - 1][count + 2], ics_detail[numEvents - 1][count + 3]);
-            strcpy(summary, ics_detail[numEvents - 1][count + 3]); strcpy(position, ics_detail[numEvents - 1][count + 2]);
-            while (compareDates(preStartDate, untilDate) <= 0 && compareDates(preEndDate, untilDate) <= 0){
-                numEvents++; strcpy(ics_detail[numEvents - 1][count], preStartDate); strcpy(ics_detail[numEvents - 1][count+1], preEndDate);
-                strcpy(ics_detail[numEvents - 1][count+2], position); strcpy(ics_detail[numEvents - 1][count+3], summary);
-                addDaysToPreStartDate(preStartDate); addDaysToPreStartDate(preEndDate);
-            }
-        } 
-        if (count >= 1 && count <= 4) {
-            char *token = strtok(buffer, ":");
-            token = strtok(NULL, ":");
-            token[strcspn(token, "\n")] = '\0';
-            strcpy(ics_detail[numEvents - 1][count - 1], token);
-            if (count == 1) {
-                strcpy(preStartDate, token);} else if (count == 2) {strcpy(preEndDate, token);
-            }
-            count++;
-        }
+int loadDisplayZone(const char *name, tz_t *display) {
+    if (name != NULL) {
+        return tz_load(name, display);
+    }
+    const char *env = getenv("TZ");
+    if (env != NULL && env[0] != '\0' && tz_load(env, display)) {
+        return 1;
     }
-    return numEvents;
+    tz_load("/etc/localtime", display);
+    return 1;
 }
 
 /**
- * Function: getNextBufferInfo
- * ---------------------------
- * @brief Reads the next buffer from the ICS file and extracts position and summary information.
+ * Function: loadCalendar
+ * ----------------------
+ * @brief Reads the events of a calendar and builds their interval index.
  *
- * This function reads the next buffer from the provided ICS file and extracts the position
- * and summary information. It stores the extracted position in the 'position' array and the
- * extracted summary in the 'summary' array.
+ * With `useCache`, the events and their index are loaded from the cache next to the
+ * file (see cache.h) when it is up to date, and the cache is rebuilt from the file
+ * otherwise. The program exits if the file cannot be opened.
  *
- * @param ics The file pointer to the ICS file.
- * @param position The array to store the extracted position information.
- * @param summary The array to store the extracted summary information.
+ * @param filename The path of the calendar.
+ * @param useCache Whether --cache was given.
+ * @param threads The number of threads to read the file with (see ics_read_file()).
+ * @param calendar The calendar to fill in.
+ * @return void
  *
  */
-void getNextBufferInfo(FILE *ics, char position[], char summary[]) {
-    char buffer[1024];
-    char *token;
-
-    fgets(buffer, sizeof(buffer), ics);
-    buffer[strcspn(buffer, "\n")] = '\0';
-
-    if (strstr(buffer, "LOCATION") != NULL) {
-        token = strtok(buffer, ":");
-        token = strtok(NULL, ":");
-        strcpy(position, token);
+void loadCalendar(const char *filename, int useCache, int threads, calendar_t *calendar) {
+    calendar->cache = useCache ? cache_open(filename) : NULL;
+    if (calendar->cache != NULL) {
+        calendar->table = &calendar->cache->table;
+        calendar->index = &calendar->cache->index;
+        return;
     }
 
-    fgets(buffer, sizeof(buffer), ics);
-    buffer[strcspn(buffer, "\n")] = '\0';
-    
-    if (strstr(buffer, "SUMMARY") != NULL) {
-        token = strtok(buffer, ":");
-        token = strtok(NULL, ":");
-        strcpy(summary, token);
+    calendar->table = table_create();
+    if (ics_read_file(filename, calendar->table, threads) < 0) {
+        fprintf(stderr, "unable to open %s\n", filename);
+        exit(1);
+    }
+    calendar->index = index_create(calendar->table);
+    if (useCache) {
+        cache_write(filename, calendar->table, calendar->index);
     }
 }
 
 /**
- * Function: getUntilDate
+ * Function: freeCalendar
  * ----------------------
- * @brief Extracts the UNTIL date from the given RRULE line.
+ * @brief Frees the events and the index of a calendar.
  *
- * This function searches for the "UNTIL=" key in the provided RRULE line and extracts
- * the date string following it. The extracted date is stored in the 'untilDate' buffer.
- * If the "UNTIL=" key is not found, the 'untilDate' buffer is set to an empty string.
- * For example: getUntilDate("RRULE:FREQ=WEEKLY;UNTIL=20201231T000000Z") stores "20201231"
- * 
- * @param rruleLine The RRULE line to search for the "UNTIL=" key.
- * @param untilDate The buffer to store the extracted UNTIL date.
+ * @param calendar The calendar.
+ * @return void
  *
  */
-void getUntilDate(const char* rruleLine, char* untilDate) {
-    const char* searchKey = "UNTIL=";
-
-    const char* untilPos = strstr(rruleLine, searchKey);
-    if (untilPos == NULL) {
-        strcpy(untilDate, "");
+void freeCalendar(calendar_t *calendar) {
+    if (calendar->cache != NULL) {
+        cache_close(calendar->cache);
         return;
     }
-
-    untilPos += strlen(searchKey);
-    strncpy(untilDate, untilPos, 8);
-    untilDate[8] = '\0';
+    index_free(calendar->index);
+    table_free(calendar->table);
 }
 
 /**
- * Function: compareDates
- * ----------------------
- * @brief Compares two date strings and returns the result.
+ * Function: parseDate
+ * -------------------
+ * @brief Parses a date of the command line into an integer date.
  *
- * This function compares the date portion of the two provided date strings:
- * 'preStartDate' and 'untilDate'. The date portion should be in the format "YYYYMMDD".
- * The function returns an integer value indicating the result of the comparison:
- *   - If 'preStartDate' is earlier than 'untilDate', a negative value is returned.
- *   - If 'preStartDate' is later than 'untilDate', a positive value is returned.
- *   - If 'preStartDate' is equal to 'untilDate', 0 is returned.
+ * This function takes a date string in the format "yyyy/mm/dd", where the month and
+ * day need not be padded, and packs it into an integer of the form YYYYMMDD, which
+ * compares directly against the date part of an event timestamp (see parse_timestamp()).
+ * For example: parseDate("2020/1/1") returns 20200101.
  *
- * @param preStartDate The date string to compare with 'untilDate'.
- * @param untilDate The date string to compare with 'preStartDate'.
- * @return int The result of the date comparison.
+ * @param date The date string to be parsed.
+ * @return long long The date in the format YYYYMMDD.
  *
  */
-int compareDates(const char* preStartDate, const char* untilDate) {
-    char preDate[9];
-    strncpy(preDate, preStartDate, 8);
-    preDate[8] = '\0';
+long long parseDate(const char *date) {
+    char *rest;
+    long year = strtol(date, &rest, 10);
+    long month = *rest == '/' ? strtol(rest + 1, &rest, 10) : 0;
+    long day = *rest == '/' ? strtol(rest + 1, &rest, 10) : 0;
 
-    return strcmp(preDate, untilDate);
+    return (year * 100 + month) * 100LL + day;
 }
 
 /**
- * Function: addDaysToPreStartDate
- * -------------------------------
- * @brief Adds 7 days to the provided preStartDate string.
+ * Function: readWindows
+ * ---------------------
+ * @brief Reads the date windows of a batch query.
  *
- * This function takes a date-time string 'preStartDate' in the format "YYYYMMDDTHHMMSS"
- * and adds 7 days to the date component. The updated date-time string is stored back
- * in the 'preStartDate' parameter.
+ * Each line holds the start and end dates of a window, separated by spaces, either
+ * bare ("2023/1/1 2023/1/31") or as on the command line ("--start=2023/1/1
+ * --end=2023/1/31"). Blank lines are skipped; any other line without exactly two
+ * dates is an error, which ends the program.
  *
- * @param preStartDate The preStartDate string to update.
+ * @param path The file to read, or "-" for the standard input.
+ * @param numWindows Set to the number of windows read.
+ * @return window_t* The windows, in the order they were read.
  *
  */
-void addDaysToPreStartDate(char *preStartDate) {
-    int year, month, day, hour, minute, second;
-
-    sscanf(preStartDate, "%4d%2d%2dT%2d%2d%2d", &year, &month, &day, &hour, &minute, &second);
-
-    day += 7;
-
-    if (day > 28) {
-        if ((month == 2 && day > 29) || ((month == 4 || month == 6 || month == 9 || month == 11) && day > 30) || day > 31) {
-            day = 1; month++;
-            if (month > 12) {
-                month = 1;
-                year++;
-            }
+window_t *readWindows(const char *path, int *numWindows) {
+    FILE *input = strcmp(path, "-") == 0 ? stdin : fopen(path, "r");
+    if (input == NULL) {
+        fprintf(stderr, "unable to open %s\n", path);
+        exit(1);
+    }
+    int capacity = 16; char line[256]; int lineNumber = 0;
+    window_t *windows = (window_t *)emalloc(capacity * sizeof(window_t));
+    *numWindows = 0;
+    while (fgets(line, sizeof(line), input) != NULL) {
+        char start[32]; char end[32]; char extra[2];
+        lineNumber++;
+        int fields = sscanf(line, "%31s %31s %1s", start, end, extra);
+        if (fields == EOF) {continue;}
+        if (fields != 2) {
+            fprintf(stderr, "bad window on line %d of %s\n", lineNumber, path);
+            exit(1);
         }
+        if (*numWindows == capacity) {
+            window_t *bigger = (window_t *)emalloc(2 * capacity * sizeof(window_t));
+            memcpy(bigger, windows, capacity * sizeof(window_t));
+            free(windows);
+            windows = bigger; capacity *= 2;
+        }
+        window_t *window = &windows[(*numWindows)++];
+        const char *from = strncmp(start, "--start=", 8) == 0 ? start + 8 : start;
+        const char *to = strncmp(end, "--end=", 6) == 0 ? end + 6 : end;
+        snprintf(window->start, sizeof(window->start), "%s", from);
+        snprintf(window->end, sizeof(window->end), "%s", to);
+        window->from = parseDate(from);
+        window->to = parseDate(to);
     }
-    sprintf(preStartDate, "%04d%02d%02dT%02d%02d%02d", year, month, day, hour, minute, second);
+    if (input != stdin) {fclose(input);}
+    return windows;
 }
 
 /**
- * Function: timeCheck
- * -------------------
- * @brief Compares two dates and checks if they satisfy a specific condition.
- *
- * This function compares two dates represented as strings ('date1' and 'date2')
- * in the format "YYYYMMDD" and checks if they satisfy a specific condition
- * indicated by the 'word' parameter. The condition can be either "Start" or "End".
- *
- * @param date1 The first date to compare.
- * @param date2 The second date to compare.
- * @param word  The condition to check. Possible values are "Start" or "End".
- * @return int  Returns 1 if the condition is satisfied, 0 otherwise.
+ * Function: process
+ * -----------------
+ * @brief Prints the events that fall within the given date range.
+ *
+ * This function asks the interval index of each calendar for the events that may fall
+ * within the date range (startDate to endDate), so only those are looked at. Each
+ * calendar yields its occurrences in the range in chronological order (see agenda.h),
+ * and a k-way merge of these streams feeds printout() directly; occurrences that start
+ * at the same time are printed in the order of the files, then of the events in each. The
+ * dates are compared as integers, and recurring events are expanded lazily: only their
+ * occurrences inside the range are generated.
+ *
+ * @param startDate    The first date of the range (YYYYMMDD).
+ * @param endDate      The last date of the range (YYYYMMDD).
+ * @param view         What to print for the occurrences.
+ * @param display      The time zone to print the occurrences in.
+ * @param calendars    The calendars.
+ * @param numCalendars The number of calendars.
+ * @return void
  *
  */
-int timeCheck(const char *date1, const char *date2, const char *word) {
-    int year1, month1, day1; int year2, month2, day2;
+void process(long long startDate, long long endDate, view_t view, const tz_t *display, calendar_t *calendars,
+             int numCalendars) {
+    window_t window = {.from = startDate, .to = endDate, .start = "", .end = ""};
+    openWindow(&window, view, numCalendars, output_open(stdout));
+    agenda_t **agendas = (agenda_t **)emalloc(numCalendars * sizeof(agenda_t *));
+    for (int i = 0; i < numCalendars; i++) {
+        agendas[i] = agenda_create(calendars[i].table, calendars[i].index, startDate, endDate, display);
+    }
+    merge_t *merge = merge_create(agendas, numCalendars);
+    event_t occurrence; int from;
+    while (merge_next(merge, &occurrence, &from)) {
+        emit(&window, &occurrence, from, calendars);
+    }
+    finishWindow(&window);
+    output_close(window.out);
+    merge_free(merge);
+    for (int i = 0; i < numCalendars; i++) {
+        agenda_free(agendas[i]);
+    }
+    free(agendas);
+}
 
-    sscanf(date1, "%4d%2d%2d", &year1, &month1, &day1);
-    sscanf(date2, "%4d%2d%2d", &year2, &month2, &day2);
+/**
+ * Function: processBatch
+ * ----------------------
+ * @brief Prints the events that fall within each of several date windows.
+ *
+ * The windows are sorted by start date and split into groups whose ranges overlap.
+ * Each group is answered by one sweep: a single merged occurrence stream over the
+ * union of its windows, in which each occurrence is handed to every window that
+ * has started and still contains it; a window is dropped from the sweep once the
+ * stream has moved past its end. The output of each window is collected on its own,
+ * then all of them are printed in the order the windows were given, each under a
+ * "=== start end ===" line and separated by blank lines.
+ *
+ * @param windows      The windows.
+ * @param numWindows   The number of windows.
+ * @param view         What to print for the occurrences.
+ * @param display      The time zone to print the occurrences in.
+ * @param calendars    The calendars.
+ * @param numCalendars The number of calendars.
+ * @return void
+ *
+ */
+void processBatch(window_t *windows, int numWindows, view_t view, const tz_t *display, calendar_t *calendars,
+                  int numCalendars) {
+    window_t **sorted = (window_t **)emalloc((numWindows > 0 ? numWindows : 1) * sizeof(window_t *));
+    window_t **active = (window_t **)emalloc((numWindows > 0 ? numWindows : 1) * sizeof(window_t *));
+    agenda_t **agendas = (agenda_t **)emalloc(numCalendars * sizeof(agenda_t *));
+    for (int i = 0; i < numWindows; i++) {
+        openWindow(&windows[i], view, numCalendars, output_open(NULL));
+        sorted[i] = &windows[i];
+    }
+    qsort(sorted, numWindows, sizeof(window_t *), compareWindows);
 
-    if (strcmp(word, "Start") == 0) {
-        if (year1 < year2) {return 1;} 
-            else if (year1 == year2) {
-            if (month1 < month2) {return 1;}
-                else if (month1 == month2) {if (day1 <= day2) {return 1;}}
+    for (int group = 0; group < numWindows;) {
+        long long from = sorted[group]->from; long long to = sorted[group]->to;
+        int last = group + 1;
+        while (last < numWindows && sorted[last]->from <= to) {
+            if (sorted[last]->to > to) {to = sorted[last]->to;}
+            last++;
         }
-    } else if (strcmp(word, "End") == 0) {
-        if (year1 > year2) {
-            return 1;
-        } else if (year1 == year2) {
-            if (month1 > month2) {return 1;} 
-                else if (month1 == month2) {
-                if (day1 >= day2) {return 1;}
+        for (int i = 0; i < numCalendars; i++) {
+            agendas[i] = agenda_create(calendars[i].table, calendars[i].index, from, to, display);
+        }
+        merge_t *merge = merge_create(agendas, numCalendars);
+        event_t occurrence; int calendar; int next = group; int numActive = 0;
+        while (merge_next(merge, &occurrence, &calendar)) {
+            long long date = occurrence.start / 1000000; long long endDate = occurrence.end / 1000000;
+            while (next < last && sorted[next]->from <= date) {active[numActive++] = sorted[next++];}
+            for (int i = 0; i < numActive;) {
+                if (active[i]->to < date) {active[i] = active[--numActive]; continue;}
+                if (endDate <= active[i]->to) {emit(active[i], &occurrence, calendar, calendars);}
+                i++;
             }
         }
+        merge_free(merge);
+        for (int i = 0; i < numCalendars; i++) {
+            agenda_free(agendas[i]);
+        }
+        group = last;
     }
-    return 0;
+
+    output_t *out = output_open(stdout);
+    for (int i = 0; i < numWindows; i++) {
+        char header[96];
+        int len = snprintf(header, sizeof(header), "%s=== %s %s ===\n", i > 0 ? "\n" : "", windows[i].start,
+                           windows[i].end);
+        output_write(out, header, len);
+        finishWindow(&windows[i]);
+        output_append(out, windows[i].out);
+        output_close(windows[i].out);
+    }
+    output_close(out);
+    free(agendas);
+    free(active);
+    free(sorted);
 }
 
 /**
- * Function: process
- * -----------------
- * @brief Processes the events based on the given information and details.
+ * Function: compareWindows
+ * ------------------------
+ * @brief Orders windows by start date, then by end date (for qsort()).
  *
- * This function processes the events based on the given information and details.
- * It compares the start and end dates of each event with the provided date range
- * (info[0] to info[1]) and prints the relevant event details. The events are
- * stored in the ics_detail array.
+ * @param a The first window.
+ * @param b The second window.
+ * @return int A negative, zero or positive number as a comes before, with or after b.
  *
- * @param info      The array containing the information and date range.
- * @param ics_detail The array containing the event details.
- * @param numEvents The number of events in the ics_detail array.
+ */
+int compareWindows(const void *a, const void *b) {
+    const window_t *window1 = *(window_t *const *)a;
+    const window_t *window2 = *(window_t *const *)b;
+    if (window1->from != window2->from) {return window1->from < window2->from ? -1 : 1;}
+    if (window1->to != window2->to) {return window1->to < window2->to ? -1 : 1;}
+    return 0;
+}
+
+/**
+ * Function: openWindow
+ * --------------------
+ * @brief Gets a window ready to be printed: nothing has been printed in it yet.
+ *
+ * @param window       The window.
+ * @param view         What to print for its occurrences.
+ * @param numCalendars The number of calendars its occurrences come from.
+ * @param out          The output to print it to.
  * @return void
  *
  */
-void process(char info[][100], char ics_detail[][4][1024], int numEvents) {
-    int matchFound = 1; int check = 1; char preDateLine[1024]; char dateLine[1024]; int first = 1;
-    for (int i = 0; i < numEvents; i++) {
-        if (timeCheck(info[0], ics_detail[i][0], "Start") == 1 &&
-            timeCheck(info[1], ics_detail[i][1], "End") == 1) {
-            char *DTstart = ics_detail[i][0]; char *DTend = ics_detail[i][1];
-            char *location = ics_detail[i][2]; char *summary = ics_detail[i][3];
-            size_t locationLength = strcspn(location, "\n"); location[locationLength] = '\0';
-            size_t summaryLength = strcspn(summary, "\n"); summary[summaryLength] = '\0';
-            int startHour, startMinute; int endHour, endMinute; int year, month, day;
-            sscanf(DTend, "%4d%2d%2dT%2d%2d", &year, &month, &day, &endHour, &endMinute);
-            sscanf(DTstart, "%4d%2d%2dT%2d%2d", &year, &month, &day, &startHour, &startMinute);
-            char *monthNames[] = {"", "January", "February", "March", "April", "May", "June",
-                                 "July", "August", "September", "October", "November", "December"};
-            char monthN[20]; strcpy(monthN, monthNames[month]);
-            char *dateDetail[] = {DTstart, DTend, location, summary, monthN};
-            int *timeDetail[] = {&startHour, &startMinute, &endHour,
-                                         &endMinute, &year, &month, &day};
-            sprintf(dateLine, "%s %d, %d\n", dateDetail[4], *timeDetail[6], *timeDetail[5]);
-            if(first){first=0; sprintf(preDateLine, "%s %d, %d\n", dateDetail[4], *timeDetail[6], *timeDetail[5]);}
-            else if(strcmp(preDateLine, dateLine) == 0){check = 0;} else {
-                check = 1; printf("\n");
-                strcpy(preDateLine, dateLine);
-            }
-            printout(dateDetail, timeDetail,check);
-            matchFound = 0;
+void openWindow(window_t *window, view_t view, int numCalendars, output_t *out) {
+    window->view = view;
+    window->out = out;
+    window->preDate = 0;
+    window->first = 1;
+    window->busyStart = 0;
+    window->busyEnd = -1;
+    window->conflicts = view == VIEW_CONFLICTS ? conflicts_create(numCalendars) : NULL;
+}
+
+/**
+ * Function: emit
+ * --------------
+ * @brief Prints an occurrence in the output of a window.
+ *
+ * The occurrences of a window come in chronological order. In the agenda, each one is
+ * printed under the date line of its day. In the free/busy view, an occurrence that
+ * starts before the busy block being built ends (or right when it ends) extends it;
+ * any other one prints the block (see flushBusy()) and starts the next. So each
+ * occurrence is looked at once, in the order the merge yields them, and no text is
+ * formatted but the blocks themselves. In the conflicts view, the occurrence moves the
+ * sweep line of the window (see conflicts_add()), and is printed, followed by the
+ * occurrences it overlaps, only if there are any.
+ *
+ * @param window     The window.
+ * @param occurrence The occurrence.
+ * @param calendar   The calendar it comes from.
+ * @param calendars  The calendars.
+ * @return void
+ *
+ */
+void emit(window_t *window, const event_t *occurrence, int calendar, const calendar_t *calendars) {
+    const string_pool_t *strings = calendars[calendar].table->strings;
+    if (window->view == VIEW_CONFLICTS) {
+        int numFound = conflicts_add(window->conflicts, occurrence, calendar, strings);
+        if (numFound == 0) {
+            return;
+        }
+        long long date = occurrence->start / 1000000;
+        printout(window->out, occurrence, strings, startDay(window, date));
+        for (int i = 0; i < numFound; i++) {
+            const conflict_t *found = &window->conflicts->found[i];
+            output_overlap(window->out, found->reason == CONFLICT_LOCATION ? "same location" : "same calendar",
+                           &found->occurrence, calendars[found->calendar].table->strings,
+                           found->occurrence.start / 1000000 != date);
+        }
+        return;
+    }
+    if (window->view == VIEW_FREEBUSY) {
+        if (window->busyEnd >= 0 && occurrence->start <= window->busyEnd) {
+            if (occurrence->end > window->busyEnd) {window->busyEnd = occurrence->end;}
+            return;
         }
+        flushBusy(window);
+        window->busyStart = occurrence->start;
+        window->busyEnd = occurrence->end > occurrence->start ? occurrence->end : occurrence->start;
+        return;
     }
+    printout(window->out, occurrence, strings, startDay(window, occurrence->start / 1000000));
 }
 
 /**
- * Function: printout
+ * Function: startDay
  * ------------------
- * @brief Prints the event details based on the provided information.
+ * @brief Gets ready to print a line of a given day in a window.
  *
- * This function prints the event details based on the provided date and time
- * information. It formats and displays the start and end times, along with
- * the event summary and location. If `check` is non-zero, it also prints the
- * formatted date line before the event details.
+ * A blank line separates the days of a window; the date line is only printed before
+ * the first line of each day.
  *
- * @param dateDetail  An array containing the date and event details.
- * @param timeDetail  An array containing the time information.
- * @param check       Flag indicating whether to print the date line.
- * @return void
+ * @param window The window.
+ * @param date   The day of the line (YYYYMMDD).
+ * @return int 1 if the date line has to be printed first, 0 otherwise.
  *
  */
-void printout(char *dateDetail[], int *timeDetail[],int check) {
-    char dateLine[1024];
-    if(check){
-        sprintf(dateLine, "%s %02d, %d\n", dateDetail[4],*timeDetail[6], *timeDetail[4]);
-        printf(dateLine);
-        int lineLength = strlen(dateLine);
-        printf("%.*s\n", lineLength - 1, "----------------------------------------------");
+int startDay(window_t *window, long long date) {
+    int check = 1;
+    if (window->first) {window->first = 0;}
+    else if (date == window->preDate) {check = 0;} else {
+        output_write(window->out, "\n", 1);
     }
-    printf("%2d:%02d %s to %2d:%02d %s: %s {{%s}}\n", convertTime(*timeDetail[0]), *timeDetail[1], getAMPM(*timeDetail[0]), convertTime(*timeDetail[2]), *timeDetail[3], getAMPM(*timeDetail[2]), dateDetail[3], dateDetail[2]);
+    window->preDate = date;
+    return check;
 }
 
 /**
- * Function: convertTime
- * ---------------------
- * @brief Converts a given hour value to a 12-hour format.
+ * Function: flushBusy
+ * -------------------
+ * @brief Prints the busy block of a window, if there is one (see output_busy()).
  *
- * This function takes an hour value and converts it to a 12-hour format.
- * If the hour is greater than 12, it subtracts 12 from it to get the
- * corresponding hour in the 12-hour format. Otherwise, it returns the
- * original hour value.
+ * @param window The window.
+ * @return void
  *
- * @param hour The hour value to be converted.
- * @return int The hour value in the 12-hour format.
+ */
+void flushBusy(window_t *window) {
+    if (window->busyEnd < 0) {
+        return;
+    }
+    if (startDay(window, window->busyStart / 1000000)) {
+        output_day(window->out, window->busyStart / 1000000);
+    }
+    output_busy(window->out, window->busyStart, window->busyEnd);
+    window->busyEnd = -1;
+}
+
+/**
+ * Function: finishWindow
+ * ----------------------
+ * @brief Prints what is left to print in a window once all its occurrences are in.
+ *
+ * @param window The window.
+ * @return void
  *
  */
-int convertTime(int hour) {
-    if (hour > 12) {
-        return hour - 12;
+void finishWindow(window_t *window) {
+    flushBusy(window);
+    if (window->conflicts != NULL) {
+        conflicts_free(window->conflicts);
+        window->conflicts = NULL;
     }
-    return hour;
 }
 
 /**
- * Function: getAMPM
- * -----------------
- * @brief Determines the appropriate AM/PM designation for a given hour.
+ * Function: printout
+ * ------------------
+ * @brief Prints the details of an event.
  *
- * This function takes an hour value and determines the appropriate AM/PM
- * designation based on the given hour. If the hour is greater than or
- * equal to 12, it returns "PM". Otherwise, it returns "AM".
+ * This function writes the start and end times of the event, along with its
+ * summary and location (see output_event()). If `check` is non-zero, it first
+ * writes the date line of the event (see output_day()).
  *
- * @param hour The hour value.
- * @return const char* The AM/PM designation ("AM" or "PM").
+ * @param out     The output to write to.
+ * @param event   The event to print.
+ * @param strings The string pool holding the location and summary of the event.
+ * @param check   Flag indicating whether to print the date line.
+ * @return void
  *
  */
-const char *getAMPM(int hour) {
-    if (hour >= 12) {
-        return "PM";
+void printout(output_t *out, const event_t *event, const string_pool_t *strings, int check) {
+    if(check){
+        output_day(out, event->start / 1000000);
     }
-    return "AM";
-}
\ No newline at end of file
+    output_event(out, event, strings);
+}
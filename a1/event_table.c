@@ -0,0 +1,431 @@
+/** @file event_table.c
+ *  @brief Implementation of event_table.h
+ *
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "emalloc.h"
+#include "event_table.h"
+
+/**
+ * Function: table_create
+ * ----------------------
+ * @brief Creates an empty event table.
+ *
+ * @return event_table_t* A pointer to the new table.
+ *
+ */
+event_table_t *table_create(void) {
+    event_table_t *table = (event_table_t *)emalloc(sizeof(event_table_t));
+
+    table->capacity = 64;
+    table->count = 0;
+    table->events = (event_t *)emalloc(table->capacity * sizeof(event_t));
+    table->rules_capacity = 16;
+    table->num_rules = 0;
+    table->rules = (recurrence_t *)emalloc(table->rules_capacity * sizeof(recurrence_t));
+    table->exclusions = NULL;
+    table->num_exclusions = 0;
+    table->exclusions_capacity = 0;
+    table->zones = NULL;
+    table->num_zones = 0;
+    table->zones_capacity = 0;
+    table->transitions = NULL;
+    table->num_transitions = 0;
+    table->transitions_capacity = 0;
+    table->deferred = NULL;
+    table->num_deferred = 0;
+    table->deferred_capacity = 0;
+    table->strings = pool_create();
+    return table;
+}
+
+/**
+ * Function: table_add
+ * -------------------
+ * @brief Appends an event that does not repeat to the table, doubling its capacity when it is full.
+ *
+ * @param table The event table.
+ * @param start The start of the event (see parse_timestamp()).
+ * @param end The end of the event.
+ * @param location The id of the location in the string pool of the table.
+ * @param summary The id of the summary in the string pool of the table.
+ * @return void
+ *
+ */
+void table_add(event_table_t *table, long long start, long long end, int location, int summary) {
+    if (table->count == table->capacity) {
+        event_t *events = (event_t *)emalloc(2 * (size_t)table->capacity * sizeof(event_t));
+        memcpy(events, table->events, table->count * sizeof(event_t));
+        free(table->events);
+        table->events = events;
+        table->capacity *= 2;
+    }
+
+    event_t *event = &table->events[table->count++];
+    event->start = start;
+    event->end = end;
+    event->location = location;
+    event->summary = summary;
+    event->rule = -1;
+    event->zone = -1;
+}
+
+/**
+ * Function: table_add_rule
+ * ------------------------
+ * @brief Stores a recurrence rule in the table.
+ *
+ * @param table The event table.
+ * @param rule The rule to store.
+ * @return int The index of the rule, to be set as the `rule` of its event.
+ *
+ */
+int table_add_rule(event_table_t *table, const recurrence_t *rule) {
+    if (table->num_rules == table->rules_capacity) {
+        recurrence_t *rules = (recurrence_t *)emalloc(2 * (size_t)table->rules_capacity * sizeof(recurrence_t));
+        memcpy(rules, table->rules, table->num_rules * sizeof(recurrence_t));
+        free(table->rules);
+        table->rules = rules;
+        table->rules_capacity *= 2;
+    }
+
+    table->rules[table->num_rules] = *rule;
+    return table->num_rules++;
+}
+
+/**
+ * Function: find_exclusion
+ * ------------------------
+ * @brief Finds the slot of an (event, start) key in the hash set of EXDATEs.
+ *
+ * @param exclusions The slots of the hash set (a power of two of them, not all full).
+ * @param capacity The number of slots.
+ * @param event The index of the event.
+ * @param start The start of the occurrence, or a whole day (see exclusion_t).
+ * @return int The slot holding the key, or the empty slot where it would go.
+ *
+ */
+static int find_exclusion(const exclusion_t *exclusions, int capacity, int event, long long start) {
+    unsigned long long hash = (unsigned long long)start * 0x9E3779B97F4A7C15ULL ^
+                              (unsigned long long)(unsigned int)event * 0xC2B2AE3D27D4EB4FULL;
+    int slot = (int)((hash ^ (hash >> 29)) & (unsigned long long)(capacity - 1));
+
+    while (exclusions[slot].event >= 0 &&
+           (exclusions[slot].event != event || exclusions[slot].start != start)) {
+        slot = (slot + 1) & (capacity - 1);
+    }
+    return slot;
+}
+
+/**
+ * Function: table_exclude
+ * -----------------------
+ * @brief Cancels an occurrence of an event (an EXDATE), growing the hash set when it is half full.
+ *
+ * @param table The event table.
+ * @param event The index of the event.
+ * @param start The start of the occurrence, or a whole day (see exclusion_t).
+ * @return void
+ *
+ */
+void table_exclude(event_table_t *table, int event, long long start) {
+    if (2 * (table->num_exclusions + 1) > table->exclusions_capacity) {
+        int capacity = table->exclusions_capacity > 0 ? 2 * table->exclusions_capacity : 16;
+        exclusion_t *exclusions = (exclusion_t *)emalloc(capacity * sizeof(exclusion_t));
+        for (int i = 0; i < capacity; i++) {
+            exclusions[i].start = 0;
+            exclusions[i].event = -1;
+        }
+        for (int i = 0; i < table->exclusions_capacity; i++) {
+            const exclusion_t *old = &table->exclusions[i];
+            if (old->event >= 0) {
+                exclusions[find_exclusion(exclusions, capacity, old->event, old->start)] = *old;
+            }
+        }
+        free(table->exclusions);
+        table->exclusions = exclusions;
+        table->exclusions_capacity = capacity;
+    }
+
+    int slot = find_exclusion(table->exclusions, table->exclusions_capacity, event, start);
+    if (table->exclusions[slot].event < 0) {
+        table->exclusions[slot].start = start;
+        table->exclusions[slot].event = event;
+        table->num_exclusions++;
+    }
+}
+
+/**
+ * Function: table_is_excluded
+ * ---------------------------
+ * @brief Checks whether an occurrence of an event is cancelled by an EXDATE, at its
+ *        start time or for its whole day.
+ *
+ * @param table The event table.
+ * @param event The index of the event.
+ * @param start The start of the occurrence (YYYYMMDDhhmmss).
+ * @return int 1 if the occurrence is cancelled, 0 otherwise.
+ *
+ */
+int table_is_excluded(const event_table_t *table, int event, long long start) {
+    if (table->num_exclusions == 0) {
+        return 0;
+    }
+    long long day = start / 1000000 * 1000000 + 999999;
+    return table->exclusions[find_exclusion(table->exclusions, table->exclusions_capacity, event, start)].event >= 0 ||
+           table->exclusions[find_exclusion(table->exclusions, table->exclusions_capacity, event, day)].event >= 0;
+}
+
+/**
+ * Function: table_defer_date
+ * --------------------------
+ * @brief Keeps an EXDATE or RDATE until the time zones of the table are known.
+ *
+ * @param table The event table.
+ * @param date The date, and the event it belongs to.
+ * @return void
+ *
+ */
+void table_defer_date(event_table_t *table, const deferred_date_t *date) {
+    if (table->num_deferred == table->deferred_capacity) {
+        int capacity = table->deferred_capacity > 0 ? 2 * table->deferred_capacity : 8;
+        deferred_date_t *deferred = (deferred_date_t *)emalloc(capacity * sizeof(deferred_date_t));
+        if (table->num_deferred > 0) {
+            memcpy(deferred, table->deferred, table->num_deferred * sizeof(deferred_date_t));
+        }
+        free(table->deferred);
+        table->deferred = deferred;
+        table->deferred_capacity = capacity;
+    }
+    table->deferred[table->num_deferred++] = *date;
+}
+
+/**
+ * Function: table_zone
+ * --------------------
+ * @brief Gets the id of a time zone of the table by name, adding it (not yet defined) if it is new.
+ *
+ * @param table The event table.
+ * @param name The name of the zone, i.e. its TZID.
+ * @param len The length of the name.
+ * @return int The id of the zone, to be set as the `zone` of its events.
+ *
+ */
+int table_zone(event_table_t *table, const char *name, size_t len) {
+    int id = pool_intern(table->strings, name, len);
+
+    for (int i = 0; i < table->num_zones; i++) {
+        if (table->zones[i].name == id) {
+            return i;
+        }
+    }
+    if (table->num_zones == table->zones_capacity) {
+        int capacity = table->zones_capacity > 0 ? 2 * table->zones_capacity : 4;
+        tz_zone_t *zones = (tz_zone_t *)emalloc(capacity * sizeof(tz_zone_t));
+        if (table->num_zones > 0) {
+            memcpy(zones, table->zones, table->num_zones * sizeof(tz_zone_t));
+        }
+        free(table->zones);
+        table->zones = zones;
+        table->zones_capacity = capacity;
+    }
+
+    tz_zone_t *zone = &table->zones[table->num_zones];
+    zone->name = id;
+    zone->first = -1;
+    zone->count = 0;
+    zone->offset = 0;
+    zone->system = 0;
+    zone->stamp = -1;
+    return table->num_zones++;
+}
+
+/**
+ * Function: table_define_zone
+ * ---------------------------
+ * @brief Defines a time zone of the table, copying its transitions; a zone keeps its first definition.
+ *
+ * @param table The event table.
+ * @param zone The id of the zone.
+ * @param tz The compiled zone (see tz.h).
+ * @return void
+ *
+ */
+void table_define_zone(event_table_t *table, int zone, const tz_t *tz) {
+    if (table->zones[zone].first >= 0) {
+        return;
+    }
+    if (table->num_transitions + tz->count > table->transitions_capacity) {
+        int capacity = table->transitions_capacity > 0 ? table->transitions_capacity : 64;
+        while (table->num_transitions + tz->count > capacity) {
+            capacity *= 2;
+        }
+        tz_transition_t *transitions = (tz_transition_t *)emalloc(capacity * sizeof(tz_transition_t));
+        if (table->num_transitions > 0) {
+            memcpy(transitions, table->transitions, table->num_transitions * sizeof(tz_transition_t));
+        }
+        free(table->transitions);
+        table->transitions = transitions;
+        table->transitions_capacity = capacity;
+    }
+    if (tz->count > 0) {
+        memcpy(table->transitions + table->num_transitions, tz->transitions, tz->count * sizeof(tz_transition_t));
+    }
+    table->zones[zone].first = table->num_transitions;
+    table->zones[zone].count = tz->count;
+    table->zones[zone].offset = tz->offset;
+    table->num_transitions += tz->count;
+}
+
+/**
+ * Function: table_get_zone
+ * ------------------------
+ * @brief Gets a time zone of the table, as a view into its transitions.
+ *
+ * @param table The event table.
+ * @param zone The id of the zone.
+ * @param tz Set to the zone; it must not be freed.
+ * @return int 1 if the zone is defined, 0 otherwise.
+ *
+ */
+int table_get_zone(const event_table_t *table, int zone, tz_t *tz) {
+    const tz_zone_t *z = &table->zones[zone];
+
+    tz->transitions = z->first >= 0 ? table->transitions + z->first : NULL;
+    tz->count = z->count;
+    tz->capacity = z->count;
+    tz->offset = z->offset;
+    return z->first >= 0;
+}
+
+/**
+ * Function: table_append
+ * ----------------------
+ * @brief Appends the events of another table, with their rules and strings.
+ *
+ * The strings of `other` are interned in the pool of `table` in the order of their
+ * ids, so appending the tables read from consecutive parts of a file gives the same
+ * ids, events, rules, EXDATEs and deferred dates as reading the whole file into one
+ * table. Time zones are matched by name, so an event may use a VTIMEZONE read in an
+ * earlier part.
+ *
+ * @param table The event table to append to.
+ * @param other The event table to append.
+ * @return void
+ *
+ */
+void table_append(event_table_t *table, const event_table_t *other) {
+    int *ids = (int *)emalloc((other->strings->count > 0 ? other->strings->count : 1) * sizeof(int));
+    int *zones = (int *)emalloc((other->num_zones > 0 ? other->num_zones : 1) * sizeof(int));
+    int firstRule = table->num_rules;
+    int firstEvent = table->count;
+
+    for (int i = 0; i < other->strings->count; i++) {
+        const char *text = pool_get(other->strings, i);
+        ids[i] = pool_intern(table->strings, text, strlen(text));
+    }
+    for (int i = 0; i < other->num_zones; i++) {
+        const char *name = pool_get(other->strings, other->zones[i].name);
+        tz_t tz;
+        zones[i] = table_zone(table, name, strlen(name));
+        if (table_get_zone(other, i, &tz)) {
+            table_define_zone(table, zones[i], &tz);
+        }
+        if (other->zones[i].system && !table->zones[zones[i]].system) {
+            table->zones[zones[i]].system = 1;
+            table->zones[zones[i]].stamp = other->zones[i].stamp;
+        }
+    }
+    for (int i = 0; i < other->num_rules; i++) {
+        table_add_rule(table, &other->rules[i]);
+    }
+    for (int i = 0; i < other->count; i++) {
+        const event_t *event = &other->events[i];
+        table_add(table, event->start, event->end, ids[event->location], ids[event->summary]);
+        table->events[table->count - 1].rule = event->rule >= 0 ? firstRule + event->rule : -1;
+        table->events[table->count - 1].zone = event->zone >= 0 ? zones[event->zone] : -1;
+    }
+    for (int i = 0; i < other->exclusions_capacity; i++) {
+        if (other->exclusions[i].event >= 0) {
+            table_exclude(table, firstEvent + other->exclusions[i].event, other->exclusions[i].start);
+        }
+    }
+    for (int i = 0; i < other->num_deferred; i++) {
+        deferred_date_t date = other->deferred[i];
+        date.event += firstEvent;
+        date.zone = date.zone >= 0 ? zones[date.zone] : -1;
+        table_defer_date(table, &date);
+    }
+    free(zones);
+    free(ids);
+}
+
+/**
+ * Function: parse_digits
+ * ----------------------
+ * @brief Reads up to `count` decimal digits as a number, padding a short run with zeros.
+ *
+ * @param text The text to read; it is advanced past the digits read.
+ * @param count The number of digits to read.
+ * @return long long The number, as if `count` digits had been read.
+ *
+ */
+static long long parse_digits(const char **text, int count) {
+    long long value = 0;
+    int i = 0;
+
+    for (; i < count && **text >= '0' && **text <= '9'; i++) {
+        value = value * 10 + (*(*text)++ - '0');
+    }
+    for (; i < count; i++) {
+        value *= 10;
+    }
+    return value;
+}
+
+/**
+ * Function: parse_timestamp
+ * -------------------------
+ * @brief Parses an iCalendar date-time into an integer timestamp.
+ *
+ * For example: parse_timestamp("20230601T111500") returns 20230601111500. A date
+ * without a time (e.g. "20230601") is taken to start at midnight. Since the digits
+ * are already in the order of the timestamp, they are accumulated directly rather
+ * than split into fields and recombined.
+ *
+ * @param text The date-time in the format "YYYYMMDDTHHMMSS" or "YYYYMMDD".
+ * @return long long The timestamp in the format YYYYMMDDhhmmss.
+ *
+ */
+long long parse_timestamp(const char *text) {
+    long long date = parse_digits(&text, 8);
+    long long time = 0;
+
+    if (*text == 'T') {
+        text++;
+        time = parse_digits(&text, 6);
+    }
+    return date * 1000000 + time;
+}
+
+/**
+ * Function: table_free
+ * --------------------
+ * @brief Frees an event table and its strings.
+ *
+ * @param table The event table.
+ * @return void
+ *
+ */
+void table_free(event_table_t *table) {
+    free(table->events);
+    free(table->rules);
+    free(table->exclusions);
+    free(table->zones);
+    free(table->transitions);
+    free(table->deferred);
+    pool_free(table->strings);
+    free(table);
+}
@@ -0,0 +1,153 @@
+/** @file event_table.h
+ *  @brief Function prototypes for the growable table of calendar events.
+ *
+ */
+#ifndef _EVENT_TABLE_H_
+#define _EVENT_TABLE_H_
+
+#include "intern.h"
+#include "tz.h"
+
+/**
+ * @brief The FREQ of a recurrence rule.
+ */
+typedef enum frequency {
+    FREQ_DAILY,
+    FREQ_WEEKLY,
+    FREQ_MONTHLY,
+    FREQ_YEARLY
+} frequency_t;
+
+/**
+ * @brief How an event repeats: a parsed RFC 5545 RRULE.
+ *
+ * `count` is 0 and `until` (YYYYMMDDhhmmss) is 0 when the rule does not set them;
+ * `until_utc` is set while an UNTIL given in UTC (ending in 'Z') is not yet in the
+ * time zone of its event.
+ * Weekdays are numbered from Monday (0) to Sunday (6). `byday[w]` holds the BYDAY
+ * entries for weekday w: bit 0 for a plain weekday (e.g. MO), bits 1 to 5 for the
+ * 1st to 5th one of the period (e.g. 2MO) and bits 6 to 10 for the last to 5th
+ * last (e.g. -1MO). Bit d of `bymonthday` stands for BYMONTHDAY=d and bit 32 + d
+ * for BYMONTHDAY=-d, and bit m of `bymonth` for BYMONTH=m.
+ */
+typedef struct recurrence {
+    frequency_t freq;
+    int interval;
+    int count;
+    int wkst;
+    long long until;
+    int until_utc;
+    unsigned short byday[7];
+    unsigned short bymonth;
+    unsigned long long bymonthday;
+} recurrence_t;
+
+/**
+ * @brief An event, or one occurrence of a recurring event.
+ *
+ * The start and end are integer timestamps of the form YYYYMMDDhhmmss (so
+ * 2023-06-01 11:15:00 is 20230601111500), which order the same way as the
+ * dates they stand for. The location and summary are ids in the string pool
+ * of the table. A recurring event is stored once, as its first occurrence,
+ * with `rule` indexing its recurrence in the table (-1 if it does not repeat).
+ * The times are on the clock of the time zone `zone` of the table (-1 for
+ * floating times, which are read the same in any zone).
+ */
+typedef struct event {
+    long long start;
+    long long end;
+    int location;
+    int summary;
+    int rule;
+    int zone;
+} event_t;
+
+/**
+ * @brief An occurrence of an event that is cancelled by an EXDATE.
+ *
+ * `start` is the start of the occurrence (YYYYMMDDhhmmss), or a whole day as
+ * YYYYMMDD999999 (an EXDATE without a time). An empty slot of the hash set of
+ * the table has an `event` of -1.
+ */
+typedef struct exclusion {
+    long long start;
+    int event;
+} exclusion_t;
+
+/**
+ * @brief An EXDATE (`rdate` is 0) or RDATE of an event that is given in another time
+ *        zone than its DTSTART, kept until the zones are known: its start and end
+ *        (0 but for a period) are on the clock of `zone`.
+ */
+typedef struct deferred_date {
+    long long start;
+    long long end;
+    int event;
+    int zone;
+    int rdate;
+} deferred_date_t;
+
+/**
+ * @brief A time zone the events of a table refer to, by its name (an id in the string
+ *        pool of the table): its transitions are `count` transitions of the table
+ *        from `first` on, and `offset` is its UTC offset before them. `first` is -1
+ *        while the zone is not defined (see table_define_zone()). `system` is set
+ *        once the zone has been looked up among the zones of the system, and `stamp`
+ *        is then what tz_stamp() gave for it.
+ */
+typedef struct tz_zone {
+    int name;
+    int first;
+    int count;
+    int offset;
+    int system;
+    long long stamp;
+} tz_zone_t;
+
+/**
+ * @brief A growable array of events and of their recurrence rules, plus the pool
+ *        their strings are interned in.
+ *
+ * The EXDATEs of all the events are kept in `exclusions`, an open-addressing
+ * hash set of (event, start) keys with `exclusions_capacity` slots (a power of
+ * two, or 0 while there are none), so checking an occurrence takes one or two
+ * probes however many exceptions its event has. The time zones of the events
+ * are in `zones`, and the transitions of all of them in `transitions`. The
+ * EXDATEs and RDATEs that wait for the zones to be known are in `deferred`.
+ */
+typedef struct event_table {
+    event_t *events;
+    int count;
+    int capacity;
+    recurrence_t *rules;
+    int num_rules;
+    int rules_capacity;
+    exclusion_t *exclusions;
+    int num_exclusions;
+    int exclusions_capacity;
+    tz_zone_t *zones;
+    int num_zones;
+    int zones_capacity;
+    tz_transition_t *transitions;
+    int num_transitions;
+    int transitions_capacity;
+    deferred_date_t *deferred;
+    int num_deferred;
+    int deferred_capacity;
+    string_pool_t *strings;
+} event_table_t;
+
+event_table_t *table_create(void);
+void table_add(event_table_t *table, long long start, long long end, int location, int summary);
+int table_add_rule(event_table_t *table, const recurrence_t *rule);
+void table_exclude(event_table_t *table, int event, long long start);
+int table_is_excluded(const event_table_t *table, int event, long long start);
+void table_defer_date(event_table_t *table, const deferred_date_t *date);
+int table_zone(event_table_t *table, const char *name, size_t len);
+void table_define_zone(event_table_t *table, int zone, const tz_t *tz);
+int table_get_zone(const event_table_t *table, int zone, tz_t *tz);
+void table_append(event_table_t *table, const event_table_t *other);
+long long parse_timestamp(const char *text);
+void table_free(event_table_t *table);
+
+#endif
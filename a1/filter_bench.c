@@ -0,0 +1,244 @@
+/** @file filter_bench.c
+ *  @brief A benchmark of the per-event date range filter.
+ *
+ * A synthetic calendar of non-recurring events spread over several years is
+ * filtered against a one-year range four ways: with the string comparison
+ * event_manager used to run on every event (sscanf() both dates, then compare
+ * field by field), with the integer timestamps parsed once at ingest, with the
+ * occurrence iterator run on every event, and with the agenda process() reads,
+ * which only looks at the events the interval index returns and also sorts them
+ * (the index is built once, outside the timing). Each filter is timed
+ * over several runs; the best run is reported and the filters are checked to
+ * keep the same events.
+ *
+ * Usage: ./filter_bench [EVENTS] [RUNS]
+ *
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "agenda.h"
+#include "emalloc.h"
+#include "event_index.h"
+#include "event_table.h"
+#include "rrule.h"
+
+/**
+ * @brief The range every filter keeps events from, as given on the command line.
+ */
+#define RANGE_START "2023/1/1"
+#define RANGE_END "2023/12/31"
+
+/**
+ * @brief The events, both as the strings of the ICS file and as an indexed table.
+ */
+typedef struct calendar {
+    char (*start)[16];
+    char (*end)[16];
+    event_table_t *table;
+    event_index_t *index;
+} calendar_t;
+
+/**
+ * @brief Get the current time in seconds from a monotonic clock.
+ */
+static double now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/**
+ * @brief Compare two "YYYYMMDD..." dates the way event_manager used to (timeCheck()).
+ */
+static int time_check(const char *date1, const char *date2, const char *word)
+{
+    int year1, month1, day1; int year2, month2, day2;
+
+    sscanf(date1, "%4d%2d%2d", &year1, &month1, &day1);
+    sscanf(date2, "%4d%2d%2d", &year2, &month2, &day2);
+
+    if (strcmp(word, "Start") == 0) {
+        if (year1 < year2) {return 1;}
+        else if (year1 == year2) {
+            if (month1 < month2) {return 1;}
+            else if (month1 == month2) {if (day1 <= day2) {return 1;}}
+        }
+    } else if (strcmp(word, "End") == 0) {
+        if (year1 > year2) {return 1;}
+        else if (year1 == year2) {
+            if (month1 > month2) {return 1;}
+            else if (month1 == month2) {if (day1 >= day2) {return 1;}}
+        }
+    }
+    return 0;
+}
+
+/**
+ * @brief Keep the events in range by comparing their date strings.
+ */
+static long run_strings(const calendar_t *calendar)
+{
+    char from[16]; char to[16];
+    int year, month, day;
+    long kept = 0;
+
+    sscanf(RANGE_START, "%d/%d/%d", &year, &month, &day);
+    sprintf(from, "%04d%02d%02d", year, month, day);
+    sscanf(RANGE_END, "%d/%d/%d", &year, &month, &day);
+    sprintf(to, "%04d%02d%02d", year, month, day);
+    for (int i = 0; i < calendar->table->count; i++) {
+        if (time_check(from, calendar->start[i], "Start") == 1 && time_check(to, calendar->end[i], "End") == 1) {
+            kept++;
+        }
+    }
+    return kept;
+}
+
+/**
+ * @brief Keep the events in range by comparing their integer timestamps.
+ */
+static long run_integers(const calendar_t *calendar)
+{
+    const event_t *events = calendar->table->events;
+    long long from = 20230101; long long to = 20231231;
+    long kept = 0;
+
+    for (int i = 0; i < calendar->table->count; i++) {
+        if (events[i].start / 1000000 >= from && events[i].end / 1000000 <= to) {
+            kept++;
+        }
+    }
+    return kept;
+}
+
+/**
+ * @brief Keep the events in range by running the occurrence iterator on every event.
+ */
+static long run_iterator(const calendar_t *calendar)
+{
+    const event_t *events = calendar->table->events;
+    occurrence_iter_t iter; event_t occurrence;
+    long kept = 0;
+
+    for (int i = 0; i < calendar->table->count; i++) {
+        occurrences_begin(&iter, &events[i], NULL, 20230101, 20231231);
+        while (occurrences_next(&iter, &occurrence)) {
+            kept++;
+        }
+    }
+    return kept;
+}
+
+/**
+ * @brief Keep the events in range with the agenda over the interval index, as process() does.
+ */
+static long run_index(const calendar_t *calendar)
+{
+    agenda_t *agenda = agenda_create(calendar->table, calendar->index, 20230101, 20231231, NULL);
+    event_t occurrence;
+    long kept = 0;
+
+    while (agenda_next(agenda, &occurrence)) {
+        kept++;
+    }
+    agenda_free(agenda);
+    return kept;
+}
+
+/**
+ * @brief Build a calendar of `count` events of up to three hours, from 2020 to 2026.
+ */
+static calendar_t *make_calendar(int count)
+{
+    calendar_t *calendar = emalloc(sizeof(calendar_t));
+    unsigned int seed = 12345;
+
+    calendar->start = emalloc(count * sizeof(calendar->start[0]));
+    calendar->end = emalloc(count * sizeof(calendar->end[0]));
+    calendar->table = table_create();
+    int location = pool_intern(calendar->table->strings, "Room", 4);
+    int summary = pool_intern(calendar->table->strings, "Meeting", 7);
+    for (int i = 0; i < count; i++) {
+        seed = seed * 1103515245 + 12345;
+        int year = 2020 + seed % 7;
+        int month = 1 + (seed >> 8) % 12;
+        int day = 1 + (seed >> 12) % 28;
+        int hour = (seed >> 16) % 21;
+        int length = 1 + (seed >> 24) % 3;
+        sprintf(calendar->start[i], "%04d%02d%02dT%02d0000", year, month, day, hour);
+        sprintf(calendar->end[i], "%04d%02d%02dT%02d0000", year, month, day, hour + length);
+        table_add(calendar->table, parse_timestamp(calendar->start[i]), parse_timestamp(calendar->end[i]),
+                  location, summary);
+    }
+    calendar->index = index_create(calendar->table);
+    return calendar;
+}
+
+/**
+ * @brief Time the best of `runs` runs of a filter and print the result.
+ */
+static double bench(const char *name, long (*run)(const calendar_t *), const calendar_t *calendar, int runs,
+                    long *kept)
+{
+    double best = -1;
+
+    for (int i = 0; i < runs; i++) {
+        double start = now();
+        *kept = run(calendar);
+        double elapsed = now() - start;
+        if (best < 0 || elapsed < best) {
+            best = elapsed;
+        }
+    }
+
+    printf("%-10s %8.2f ms  %8.2f ns/event  %10ld kept\n",
+           name, best * 1e3, best * 1e9 / calendar->table->count, *kept);
+    return best;
+}
+
+/**
+ * @brief The main function and entry point of the benchmark.
+ *
+ * @param argc The number of arguments passed to the program.
+ * @param argv The list of arguments passed to the program.
+ * @return int 0: No errors; 1: Errors produced.
+ *
+ */
+int main(int argc, char *argv[])
+{
+    int count = argc > 1 ? atoi(argv[1]) : 1000000;
+    int runs = argc > 2 ? atoi(argv[2]) : 5;
+    calendar_t *calendar = make_calendar(count);
+    long expected, kept;
+
+    double old = bench("strings", run_strings, calendar, runs, &expected);
+    double new = bench("integers", run_integers, calendar, runs, &kept);
+    printf("speedup    %8.2fx\n", old / new);
+    if (kept != expected) {
+        printf("integers disagree with strings\n");
+        return 1;
+    }
+    new = bench("iterator", run_iterator, calendar, runs, &kept);
+    printf("speedup    %8.2fx\n", old / new);
+    if (kept != expected) {
+        printf("iterator disagrees with strings\n");
+        return 1;
+    }
+    new = bench("index", run_index, calendar, runs, &kept);
+    printf("speedup    %8.2fx\n", old / new);
+    if (kept != expected) {
+        printf("index disagrees with strings\n");
+        return 1;
+    }
+
+    index_free(calendar->index);
+    table_free(calendar->table);
+    free(calendar->start);
+    free(calendar->end);
+    free(calendar);
+    return 0;
+}
@@ -0,0 +1,273 @@
+/** @file ics.c
+ *  @brief Implementation of ics.h
+ *
+ */
+#include <stdlib.h>
+#include <string.h>
+#include "emalloc.h"
+#include "ics.h"
+
+/**
+ * @brief The number of bytes read from the file at a time.
+ */
+#define ICS_CHUNK_SIZE (1 << 16)
+
+/**
+ * Function: ics_open
+ * ------------------
+ * @brief Creates a reader over an open iCalendar file.
+ *
+ * @param file The file to read from; the caller keeps ownership of it.
+ * @return ics_reader_t* A pointer to the new reader.
+ *
+ */
+ics_reader_t *ics_open(FILE *file) {
+    ics_reader_t *reader = (ics_reader_t *)emalloc(sizeof(ics_reader_t));
+
+    reader->file = file;
+    reader->chunk = (char *)emalloc(ICS_CHUNK_SIZE);
+    reader->chunk_len = 0;
+    reader->pos = 0;
+    reader->line_capacity = 256;
+    reader->line = (char *)emalloc(reader->line_capacity);
+    reader->line_len = 0;
+    return reader;
+}
+
+/**
+ * Function: refill
+ * ----------------
+ * @brief Reads the next chunk of the file once the current one is used up.
+ *
+ * @param reader The reader.
+ * @return int 1 if there is unread data in the chunk, 0 at the end of the file.
+ *
+ */
+static int refill(ics_reader_t *reader) {
+    if (reader->pos < reader->chunk_len) {
+        return 1;
+    }
+    reader->chunk_len = fread(reader->chunk, 1, ICS_CHUNK_SIZE, reader->file);
+    reader->pos = 0;
+    return reader->chunk_len > 0;
+}
+
+/**
+ * Function: append
+ * ----------------
+ * @brief Appends bytes to the line buffer, doubling its capacity when it is full.
+ *
+ * @param reader The reader.
+ * @param text The bytes to append.
+ * @param len The number of bytes.
+ * @return void
+ *
+ */
+static void append(ics_reader_t *reader, const char *text, size_t len) {
+    if (reader->line_len + len + 1 > reader->line_capacity) {
+        size_t capacity = reader->line_capacity;
+        while (reader->line_len + len + 1 > capacity) {
+            capacity *= 2;
+        }
+        char *line = (char *)emalloc(capacity);
+        memcpy(line, reader->line, reader->line_len);
+        free(reader->line);
+        reader->line = line;
+        reader->line_capacity = capacity;
+    }
+    memcpy(reader->line + reader->line_len, text, len);
+    reader->line_len += len;
+}
+
+/**
+ * Function: read_line
+ * -------------------
+ * @brief Reads the next unfolded content line into the line buffer.
+ *
+ * Lines may end with CRLF or LF. The line break and the first space or tab of
+ * every continuation line are removed.
+ *
+ * @param reader The reader.
+ * @return int 1 if a line was read, 0 at the end of the file.
+ *
+ */
+static int read_line(ics_reader_t *reader) {
+    int found = 0;
+
+    reader->line_len = 0;
+    while (refill(reader)) {
+        const char *start = reader->chunk + reader->pos;
+        size_t available = reader->chunk_len - reader->pos;
+        const char *newline = memchr(start, '\n', available);
+        found = 1;
+        if (newline == NULL) {
+            append(reader, start, available);
+            reader->pos = reader->chunk_len;
+            continue;
+        }
+
+        append(reader, start, newline - start);
+        reader->pos += newline - start + 1;
+        if (reader->line_len > 0 && reader->line[reader->line_len - 1] == '\r') {
+            reader->line_len--;
+        }
+        if (!refill(reader) || (reader->chunk[reader->pos] != ' ' && reader->chunk[reader->pos] != '\t')) {
+            break;
+        }
+        reader->pos++;
+    }
+    reader->line[reader->line_len] = '\0';
+    return found;
+}
+
+/**
+ * Function: ics_next
+ * ------------------
+ * @brief Reads the next content line and splits it into its name, parameters and value.
+ *
+ * Blank lines are skipped. The value starts after the first ':' that is not
+ * inside a quoted parameter value; a line without one has an empty value.
+ *
+ * @param reader The reader.
+ * @param property Set to a view of the line.
+ * @return int 1 if a line was read, 0 at the end of the file.
+ *
+ */
+int ics_next(ics_reader_t *reader, ics_property_t *property) {
+    do {
+        if (!read_line(reader)) {
+            return 0;
+        }
+    } while (reader->line_len == 0);
+
+    char *line = reader->line;
+    size_t len = reader->line_len;
+    size_t i = strcspn(line, ";:");
+    int quoted = 0;
+
+    property->name = line;
+    property->name_len = i;
+    property->params = line + (i < len && line[i] == ';' ? i + 1 : i);
+    for (; i < len && (quoted || line[i] != ':'); i++) {
+        if (line[i] == '"') {
+            quoted = !quoted;
+        }
+    }
+    property->params_len = line + i - property->params;
+    property->value = line + (i < len ? i + 1 : len);
+    property->value_len = line + len - property->value;
+    return 1;
+}
+
+/**
+ * Function: equals_name
+ * ---------------------
+ * @brief Compares text against a name, ignoring case as RFC 5545 requires.
+ *
+ * @param text The text.
+ * @param len The length of the text.
+ * @param name The name, in upper case.
+ * @return int 1 if the text is the name, 0 otherwise.
+ *
+ */
+static int equals_name(const char *text, size_t len, const char *name) {
+    if (strlen(name) != len) {
+        return 0;
+    }
+    for (size_t i = 0; i < len; i++) {
+        char c = text[i];
+        if ((c >= 'a' && c <= 'z' ? c - 'a' + 'A' : c) != name[i]) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+/**
+ * Function: ics_is
+ * ----------------
+ * @brief Checks the name of a property.
+ *
+ * @param property The property.
+ * @param name The name, in upper case (e.g. "DTSTART").
+ * @return int 1 if the property has that name, 0 otherwise.
+ *
+ */
+int ics_is(const ics_property_t *property, const char *name) {
+    return equals_name(property->name, property->name_len, name);
+}
+
+/**
+ * Function: ics_value_is
+ * ----------------------
+ * @brief Checks the value of a property that names something, e.g. the component of BEGIN.
+ *
+ * @param property The property.
+ * @param value The value, in upper case (e.g. "VEVENT").
+ * @return int 1 if the property has that value, 0 otherwise.
+ *
+ */
+int ics_value_is(const ics_property_t *property, const char *value) {
+    return equals_name(property->value, property->value_len, value);
+}
+
+/**
+ * Function: ics_param
+ * -------------------
+ * @brief Gets the value of a parameter of a property, e.g. the TZID of a DTSTART.
+ *
+ * For example: the TZID of "DTSTART;TZID=America/Vancouver:20230601T090000" is
+ * "America/Vancouver". The quotes around a quoted value are left out.
+ *
+ * @param property The property.
+ * @param name The name of the parameter, in upper case.
+ * @param len Set to the length of the value.
+ * @return const char* The value (not NUL-terminated), or NULL if the property has no such parameter.
+ *
+ */
+const char *ics_param(const ics_property_t *property, const char *name, size_t *len) {
+    const char *p = property->params;
+    const char *end = property->params + property->params_len;
+
+    while (p < end) {
+        const char *equals = memchr(p, '=', end - p);
+        if (equals == NULL) {
+            return NULL;
+        }
+        const char *value = equals + 1;
+        const char *stop = value;
+        if (stop < end && *stop == '"') {
+            value++;
+            stop = memchr(value, '"', end - value);
+            stop = stop != NULL ? stop : end;
+        } else {
+            while (stop < end && *stop != ';') {
+                stop++;
+            }
+        }
+        if (equals_name(p, equals - p, name)) {
+            *len = stop - value;
+            return value;
+        }
+        p = stop < end && *stop == '"' ? stop + 1 : stop;
+        if (p < end && *p == ';') {
+            p++;
+        }
+    }
+    return NULL;
+}
+
+/**
+ * Function: ics_close
+ * -------------------
+ * @brief Frees a reader; the file is left open.
+ *
+ * @param reader The reader.
+ * @return void
+ *
+ */
+void ics_close(ics_reader_t *reader) {
+    free(reader->chunk);
+    free(reader->line);
+    free(reader);
+}
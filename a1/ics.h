@@ -0,0 +1,52 @@
+/** @file ics.h
+ *  @brief Function prototypes for the streaming iCalendar content line reader.
+ *
+ */
+#ifndef _ICS_H_
+#define _ICS_H_
+
+#include <stdio.h>
+
+/**
+ * @brief A reader that hands out the content lines of an iCalendar file one at a time.
+ *
+ * The file is read a chunk at a time into `chunk`, and each content line is
+ * unfolded (RFC 5545, section 3.1: a line break followed by a space or a tab
+ * continues the line) into `line`, which grows to hold the longest line seen.
+ * So memory stays bounded by the chunk size plus the longest line, whatever
+ * the size of the file.
+ */
+typedef struct ics_reader {
+    FILE *file;
+    char *chunk;
+    size_t chunk_len;
+    size_t pos;
+    char *line;
+    size_t line_len;
+    size_t line_capacity;
+} ics_reader_t;
+
+/**
+ * @brief A view of one content line, "NAME;PARAMS:VALUE", into the line buffer of
+ *        the reader; it stays valid until the next line is read.
+ *
+ * `params` excludes the leading ';' and is empty when there are none. The value
+ * is NUL-terminated.
+ */
+typedef struct ics_property {
+    const char *name;
+    size_t name_len;
+    const char *params;
+    size_t params_len;
+    const char *value;
+    size_t value_len;
+} ics_property_t;
+
+ics_reader_t *ics_open(FILE *file);
+int ics_next(ics_reader_t *reader, ics_property_t *property);
+int ics_is(const ics_property_t *property, const char *name);
+int ics_value_is(const ics_property_t *property, const char *value);
+const char *ics_param(const ics_property_t *property, const char *name, size_t *len);
+void ics_close(ics_reader_t *reader);
+
+#endif
@@ -0,0 +1,773 @@
+/** @file ics_parse.c
+ *  @brief Implementation of ics_parse.h
+ *
+ */
+#include <fcntl.h>
+#include <limits.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "date.h"
+#include "emalloc.h"
+#include "ics.h"
+#include "ics_parse.h"
+#include "rrule.h"
+#include "tz.h"
+
+/**
+ * @brief A part of a file read by one thread of ics_read_file(), and what it read:
+ *        its events, in a table of its own, and the nesting depth of the
+ *        components open at its end.
+ */
+typedef struct ics_part {
+    const char *data;
+    size_t len;
+    event_table_t *table;
+    int depth;
+} ics_part_t;
+
+/**
+ * @brief A date of an EXDATE or RDATE property, as a timestamp (YYYYMMDDhhmmss); a date
+ *        without a time is stored as YYYYMMDD999999. `end` is the end of a period
+ *        (an RDATE with VALUE=PERIOD), and 0 for a plain date. `zone` is the time zone
+ *        the date is given in (see dateZone()).
+ */
+typedef struct date_value {
+    long long start;
+    long long end;
+    int zone;
+} date_value_t;
+
+/**
+ * @brief The dates of the EXDATE or RDATE properties of an event.
+ */
+typedef struct date_list {
+    date_value_t *values;
+    int count;
+    int capacity;
+} date_list_t;
+
+/**
+ * @brief A VTIMEZONE being read (`open` is set from its BEGIN to its END): the zone
+ *        it defines (-1 until its TZID is read) and the transitions found so far,
+ *        the earliest of them at `first`, after which the zone had offset `base`.
+ *        `nested` counts the components open in it; inside a STANDARD or DAYLIGHT
+ *        one, the onset (DTSTART), offsets, rule and RDATEs of it are collected.
+ */
+typedef struct zone_reader {
+    int open;
+    int nested;
+    int zone;
+    tz_t tz;
+    long long first;
+    int base;
+    int hasStart;
+    int hasOffsets;
+    int repeats;
+    long long start;
+    int from;
+    int to;
+    recurrence_t rule;
+    date_list_t rdates;
+} zone_reader_t;
+
+static void addEvent(event_table_t *table, long long start, long long end, int location, int summary,
+                     const recurrence_t *rule, int zone);
+static void addDates(event_table_t *table, const date_list_t *exdates, const date_list_t *rdates);
+static void addRdate(event_table_t *table, int index, long long start, long long end);
+
+/**
+ * Function: dateZone
+ * ------------------
+ * @brief Gets the time zone of a date-time of a property (a DTSTART, EXDATE or RDATE).
+ *
+ * @param table The event table.
+ * @param property The content line.
+ * @param value The date-time, in the value of the line.
+ * @param len The length of the date-time.
+ * @return int The id of its TZID in the table, of "UTC" for a time in UTC (ending in
+ *             'Z'), or -1 for a floating time or a date without a time.
+ *
+ */
+static int dateZone(event_table_t *table, const ics_property_t *property, const char *value, size_t len) {
+    size_t nameLen;
+    const char *name = ics_param(property, "TZID", &nameLen);
+
+    if (len < 15 || value[8] != 'T') {
+        return -1;
+    }
+    if (len > 15 && value[15] == 'Z') {
+        return table_zone(table, "UTC", 3);
+    }
+    return name != NULL && nameLen > 0 ? table_zone(table, name, nameLen) : -1;
+}
+
+/**
+ * Function: parse_duration
+ * ------------------------
+ * @brief Parses an iCalendar duration (e.g. "PT1H30M", "P1DT12H" or "P2W") into seconds.
+ *
+ * @param text The duration.
+ * @return long long The number of seconds, negative for a duration starting with '-'.
+ *
+ */
+static long long parse_duration(const char *text) {
+    long long seconds = 0;
+    int sign = *text == '-' ? -1 : 1;
+
+    text += *text == '-' || *text == '+';
+    if (*text++ != 'P') {
+        return 0;
+    }
+    while (*text != '\0' && *text != ',') {
+        if (*text == 'T') {
+            text++;
+            continue;
+        }
+        char *unit;
+        long long n = strtoll(text, &unit, 10);
+        if (unit == text) {
+            break;
+        }
+        switch (*unit) {
+        case 'W': seconds += n * 7 * 86400; break;
+        case 'D': seconds += n * 86400; break;
+        case 'H': seconds += n * 3600; break;
+        case 'M': seconds += n * 60; break;
+        case 'S': seconds += n; break;
+        default: return sign * seconds;
+        }
+        text = unit + 1;
+    }
+    return sign * seconds;
+}
+
+/**
+ * Function: parse_dates
+ * ---------------------
+ * @brief Appends the comma-separated dates of an EXDATE or RDATE value to a list.
+ *
+ * A period (in an RDATE) keeps its end: the one given ("start/end"), or its start
+ * plus the duration given ("start/duration").
+ *
+ * @param table The event table the zones of the dates are named in, or NULL to
+ *              leave them floating (in a VTIMEZONE).
+ * @param property The EXDATE or RDATE line.
+ * @param dates The list.
+ * @return void
+ *
+ */
+static void parse_dates(event_table_t *table, const ics_property_t *property, date_list_t *dates) {
+    const char *value = property->value;
+
+    while (*value != '\0') {
+        size_t len = strcspn(value, ",/");
+        if (len >= 8) {
+            if (dates->count == dates->capacity) {
+                int capacity = dates->capacity > 0 ? 2 * dates->capacity : 8;
+                date_value_t *values = (date_value_t *)emalloc(capacity * sizeof(date_value_t));
+                if (dates->count > 0) {
+                    memcpy(values, dates->values, dates->count * sizeof(date_value_t));
+                }
+                free(dates->values);
+                dates->values = values;
+                dates->capacity = capacity;
+            }
+            date_value_t *date = &dates->values[dates->count++];
+            date->start = parse_timestamp(value);
+            date->end = 0;
+            date->zone = table != NULL ? dateZone(table, property, value, len) : -1;
+            if (memchr(value, 'T', len) == NULL) {
+                date->start += 999999;
+            } else if (value[len] == '/') {
+                const char *end = value + len + 1;
+                date->end = *end >= '0' && *end <= '9'
+                                ? parse_timestamp(end)
+                                : seconds_to_timestamp(timestamp_to_seconds(date->start) + parse_duration(end));
+            }
+        }
+        value += strcspn(value, ",");
+        if (*value == ',') {
+            value++;
+        }
+    }
+}
+
+/**
+ * Function: addOnset
+ * ------------------
+ * @brief Adds a transition of the VTIMEZONE being read, at a local time of the observance being read.
+ *
+ * @param reader The VTIMEZONE being read.
+ * @param onset The local time of the transition (YYYYMMDDhhmmss), on the clock before it.
+ * @return void
+ *
+ */
+static void addOnset(zone_reader_t *reader, long long onset) {
+    long long at = timestamp_to_seconds(onset) - reader->from;
+
+    tz_add(&reader->tz, at, reader->to);
+    if (at < reader->first) {
+        reader->first = at;
+        reader->base = reader->from;
+    }
+}
+
+/**
+ * Function: addObservance
+ * -----------------------
+ * @brief Adds the transitions of a STANDARD or DAYLIGHT component to the VTIMEZONE being read.
+ *
+ * The onsets are its DTSTART, the ones its RRULE gives up to TZ_LAST_YEAR and its
+ * RDATEs. A DTSTART that does not match the RRULE (e.g. 16010101T020000 for the
+ * second Sunday of March) is moved to the first day that does.
+ *
+ * @param reader The VTIMEZONE being read.
+ * @return void
+ *
+ */
+static void addObservance(zone_reader_t *reader) {
+    if (!reader->hasStart || reader->hasOffsets != 3) {
+        return;
+    }
+    long long start = reader->start;
+    if (reader->repeats) {
+        recurrence_t *rule = &reader->rule;
+        if (rule->until_utc) {
+            rule->until = seconds_to_timestamp(timestamp_to_seconds(rule->until) + reader->from);
+            rule->until_utc = 0;
+        }
+        long day = date_to_days(start / 1000000);
+        for (int i = 0; i < 366 && !rrule_matches(rule, days_to_date(day)); i++) {
+            day++;
+        }
+        start = days_to_date(day) * 1000000 + start % 1000000;
+
+        event_t onset = {start, start, 0, 0, -1, -1};
+        event_t occurrence;
+        occurrence_iter_t iter;
+        occurrences_begin(&iter, &onset, rule, start / 1000000, TZ_LAST_YEAR * 10000LL + 1231);
+        while (occurrences_next(&iter, &occurrence)) {
+            addOnset(reader, occurrence.start);
+        }
+    } else {
+        addOnset(reader, start);
+    }
+    for (int i = 0; i < reader->rdates.count; i++) {
+        long long date = reader->rdates.values[i].start;
+        addOnset(reader, date % 1000000 == 999999 ? date / 1000000 * 1000000 + reader->start % 1000000 : date);
+    }
+}
+
+/**
+ * Function: readZone
+ * ------------------
+ * @brief Reads a content line of a VTIMEZONE, if it is in one.
+ *
+ * The transitions of the zone are compiled as it is read, and it is defined in
+ * the table at its END (see table_define_zone()). A BEGIN:VEVENT line ends the
+ * VTIMEZONE it is in without defining it: a file is only ever split on such
+ * lines (see read_parts()), so it is read the same in parallel.
+ *
+ * @param table The event table.
+ * @param reader The VTIMEZONE being read.
+ * @param property The content line.
+ * @return int 1 if the line belongs to a VTIMEZONE, 0 otherwise.
+ *
+ */
+static int readZone(event_table_t *table, zone_reader_t *reader, const ics_property_t *property) {
+    if (ics_is(property, "BEGIN") && ics_value_is(property, "VEVENT")) {
+        reader->open = 0;
+        return 0;
+    }
+    if (!reader->open) {
+        if (!ics_is(property, "BEGIN") || !ics_value_is(property, "VTIMEZONE")) {
+            return 0;
+        }
+        tz_free(&reader->tz);
+        reader->open = 1;
+        reader->nested = 0;
+        reader->zone = -1;
+        reader->first = LLONG_MAX;
+        reader->base = 0;
+    } else if (ics_is(property, "BEGIN")) {
+        if (reader->nested++ == 0) {
+            reader->hasStart = 0; reader->hasOffsets = 0; reader->repeats = 0; reader->rdates.count = 0;
+        }
+    } else if (ics_is(property, "END")) {
+        if (reader->nested == 0) {
+            if (reader->zone >= 0 && reader->first != LLONG_MAX) {
+                reader->tz.offset = reader->base;
+                tz_finish(&reader->tz);
+                table_define_zone(table, reader->zone, &reader->tz);
+            }
+            reader->open = 0;
+        } else if (--reader->nested == 0) {
+            addObservance(reader);
+        }
+    } else if (reader->nested == 0) {
+        if (ics_is(property, "TZID")) {
+            reader->zone = table_zone(table, property->value, property->value_len);
+        }
+    } else if (reader->nested == 1) {
+        if (ics_is(property, "DTSTART")) {
+            reader->start = parse_timestamp(property->value); reader->hasStart = 1;
+        } else if (ics_is(property, "TZOFFSETFROM")) {
+            reader->hasOffsets |= tz_parse_offset(property->value, &reader->from);
+        } else if (ics_is(property, "TZOFFSETTO")) {
+            reader->hasOffsets |= tz_parse_offset(property->value, &reader->to) << 1;
+        } else if (ics_is(property, "RRULE")) {
+            reader->repeats = parse_rrule(property->value, &reader->rule);
+        } else if (ics_is(property, "RDATE")) {
+            parse_dates(NULL, property, &reader->rdates);
+        }
+    }
+    return 1;
+}
+
+/**
+ * Function: read_events
+ * ---------------------
+ * @brief Reads the events of an ICS file into a table (see ics_read()).
+ *
+ * @param ics The file pointer to the ICS file.
+ * @param table The table to store the extracted events in.
+ * @return int The nesting depth of the components still open at the end of the
+ *             file (0 for a well-formed file).
+ *
+ */
+static int read_events(FILE *ics, event_table_t *table) {
+    ics_reader_t *reader = ics_open(ics);
+    ics_property_t property;
+    int depth = 0; int hasStart = 0; int hasEnd = 0; int repeats = 0;
+    long long start = 0; long long end = 0; int location = 0; int summary = 0; int zone = -1;
+    recurrence_t rule;
+    date_list_t exdates = {NULL, 0, 0}; date_list_t rdates = {NULL, 0, 0};
+    zone_reader_t zoneReader;
+    int empty = pool_intern(table->strings, "", 0);
+    zoneReader.open = 0;
+    zoneReader.rdates.values = NULL; zoneReader.rdates.count = 0; zoneReader.rdates.capacity = 0;
+    tz_init(&zoneReader.tz, 0);
+    while (ics_next(reader, &property)) {
+        if (depth == 0 && readZone(table, &zoneReader, &property)) {
+            continue;
+        }
+        if (ics_is(&property, "BEGIN")) {
+            if (depth > 0 || ics_value_is(&property, "VEVENT")) {depth++;}
+            if (depth == 1 && ics_value_is(&property, "VEVENT")) {
+                hasStart = 0; hasEnd = 0; repeats = 0; location = empty; summary = empty; zone = -1;
+                exdates.count = 0; rdates.count = 0;
+            }
+        } else if (ics_is(&property, "END")) {
+            if (depth == 1 && hasStart) {
+                addEvent(table, start, hasEnd ? end : start, location, summary, repeats ? &rule : NULL, zone);
+                addDates(table, &exdates, &rdates);
+            }
+            if (depth > 0) {depth--;}
+        } else if (depth != 1) {
+            continue;
+        } else if (ics_is(&property, "DTSTART")) {
+            start = parse_timestamp(property.value); hasStart = 1; zone = dateZone(table, &property, property.value, property.value_len);
+        } else if (ics_is(&property, "DTEND")) {
+            end = parse_timestamp(property.value); hasEnd = 1;
+        } else if (ics_is(&property, "LOCATION")) {
+            location = pool_intern(table->strings, property.value, property.value_len);
+        } else if (ics_is(&property, "SUMMARY")) {
+            summary = pool_intern(table->strings, property.value, property.value_len);
+        } else if (ics_is(&property, "RRULE")) {
+            repeats = parse_rrule(property.value, &rule);
+        } else if (ics_is(&property, "EXDATE")) {
+            parse_dates(table, &property, &exdates);
+        } else if (ics_is(&property, "RDATE")) {
+            parse_dates(table, &property, &rdates);
+        }
+    }
+    if (depth > 0 && hasStart) {
+        // The file ended inside a VEVENT: keep what was read of it.
+        addEvent(table, start, hasEnd ? end : start, location, summary, repeats ? &rule : NULL, zone);
+        addDates(table, &exdates, &rdates);
+    }
+    free(exdates.values);
+    free(rdates.values);
+    free(zoneReader.rdates.values);
+    tz_free(&zoneReader.tz);
+    ics_close(reader);
+    return depth;
+}
+
+
+/**
+ * Function: resolveZones
+ * ----------------------
+ * @brief Defines the time zones no VTIMEZONE of the file defined, and puts the UNTIL
+ *        given in UTC of the rules, and the EXDATEs and RDATEs given in other zones
+ *        (see addDates()), into the zones of their events.
+ *
+ * A TZID without a VTIMEZONE is looked up among the zones of the system (see
+ * tz_load()); the events of a zone that is not found there either keep floating
+ * times, and so do the dates given in it. So does an UNTIL in UTC of an event with
+ * floating times, as if it had no 'Z' (RFC 5545 requires both to be floating).
+ *
+ * @param table The event table, once the whole file has been read into it.
+ * @return void
+ *
+ */
+static void resolveZones(event_table_t *table) {
+    tz_t tz;
+
+    for (int i = 0; i < table->num_zones; i++) {
+        if (table->zones[i].first >= 0) {
+            continue;
+        }
+        const char *name = pool_get(table->strings, table->zones[i].name);
+        if (tz_load(name, &tz)) {
+            table_define_zone(table, i, &tz);
+        }
+        tz_free(&tz);
+        table->zones[i].system = 1;
+        table->zones[i].stamp = tz_stamp(name);
+    }
+    for (int i = 0; i < table->count; i++) {
+        const event_t *event = &table->events[i];
+        if (event->rule < 0 || !table->rules[event->rule].until_utc) {
+            continue;
+        }
+        recurrence_t *rule = &table->rules[event->rule];
+        if (event->zone >= 0 && table_get_zone(table, event->zone, &tz)) {
+            rule->until = tz_from_utc(&tz, rule->until);
+        }
+        rule->until_utc = 0;
+    }
+
+    // The EXDATEs of an event come before its RDATEs, which they may cancel.
+    for (int i = 0; i < table->num_deferred; i++) {
+        deferred_date_t date = table->deferred[i];
+        tz_t from;
+        if (date.zone >= 0 && date.start % 1000000 != 999999 && table_get_zone(table, date.zone, &from) &&
+            table_get_zone(table, table->events[date.event].zone, &tz)) {
+            date.start = tz_from_utc(&tz, tz_to_utc(&from, date.start));
+            date.end = date.end != 0 ? tz_from_utc(&tz, tz_to_utc(&from, date.end)) : 0;
+        }
+        if (date.rdate) {
+            addRdate(table, date.event, date.start, date.end);
+        } else {
+            table_exclude(table, date.event, date.start);
+        }
+    }
+    free(table->deferred);
+    table->deferred = NULL;
+    table->num_deferred = 0;
+    table->deferred_capacity = 0;
+}
+
+/**
+ * Function: ics_read
+ * ------------------
+ * @brief Reads the content of the ICS file and extracts event details.
+ *
+ * This function reads the content lines of the provided ICS file one at a time
+ * (unfolded, and of any length) and extracts the start date, end date, location,
+ * summary and recurrence rule of each VEVENT, whatever order its properties come
+ * in; the properties of components nested in it (e.g. a VALARM) are skipped. Each
+ * event is appended to the event table once; a recurring event keeps its parsed
+ * RRULE and is only expanded into occurrences when the events are processed, less
+ * the ones its EXDATEs cancel (see addDates()). An event without DTSTART is
+ * dropped, and one without DTEND ends when it starts.
+ *
+ * The times of an event are kept on the clock of the time zone of its DTSTART
+ * (its TZID, or UTC for a time ending in 'Z'), which the table names, and are
+ * only converted as the occurrences are listed (see agenda.h). The zones are
+ * compiled from the VTIMEZONEs of the file, or from the zones of the system
+ * (see resolveZones()); a DTEND is taken in the zone of the DTSTART.
+ *
+ * @param ics The file pointer to the ICS file.
+ * @param table The table to store the extracted events in.
+ * @return int The number of events in the table.
+ *
+ */
+int ics_read(FILE *ics, event_table_t *table) {
+    read_events(ics, table);
+    resolveZones(table);
+    return table->count;
+}
+
+/**
+ * Function: find_split
+ * --------------------
+ * @brief Finds the first "BEGIN:VEVENT" line that starts after a given offset.
+ *
+ * @param data The content of the file.
+ * @param size The size of the file.
+ * @param from The offset to search from.
+ * @return size_t The offset of the line, or `size` if there is none.
+ *
+ */
+static size_t find_split(const char *data, size_t size, size_t from) {
+    static const char begin[] = "BEGIN:VEVENT";
+    size_t len = sizeof(begin) - 1;
+
+    while (from < size) {
+        const char *newline = memchr(data + from, '\n', size - from);
+        if (newline == NULL) {
+            break;
+        }
+        from = newline - data + 1;
+        if (size - from >= len && strncasecmp(data + from, begin, len) == 0 &&
+            (from + len == size || data[from + len] == '\r' || data[from + len] == '\n')) {
+            return from;
+        }
+    }
+    return size;
+}
+
+/**
+ * Function: read_part
+ * -------------------
+ * @brief Reads the events of a part of a file into a table of its own (the body of a thread).
+ *
+ * @param arg The part (an ics_part_t).
+ * @return void* NULL.
+ *
+ */
+static void *read_part(void *arg) {
+    ics_part_t *part = (ics_part_t *)arg;
+    FILE *ics = fmemopen((void *)part->data, part->len, "r");
+
+    part->table = table_create();
+    if (ics == NULL) {
+        // Never a well-formed end, so the file is read again in one piece.
+        part->depth = -1;
+        return NULL;
+    }
+    part->depth = read_events(ics, part->table);
+    fclose(ics);
+    return NULL;
+}
+
+/**
+ * Function: read_parts
+ * --------------------
+ * @brief Reads a file split into parts in parallel, one thread per part.
+ *
+ * Each part but the first starts with a "BEGIN:VEVENT" line. The parts are read
+ * into tables of their own, which are appended to `table` in the order of the
+ * parts (see table_append()); since a part only depends on what came before it
+ * through the components left open, this gives the table a sequential read
+ * would when every part but the last ends outside of any component. Otherwise
+ * (e.g. a VEVENT without its END) nothing is appended and 0 is returned.
+ *
+ * @param data The content of the file.
+ * @param size The size of the file.
+ * @param table The table to store the events in.
+ * @param numParts The number of parts to split the file in.
+ * @return int 1 if the events were read, 0 if the file has to be read sequentially.
+ *
+ */
+static int read_parts(const char *data, size_t size, event_table_t *table, int numParts) {
+    ics_part_t *parts = (ics_part_t *)emalloc(numParts * sizeof(ics_part_t));
+    pthread_t *threads = (pthread_t *)emalloc(numParts * sizeof(pthread_t));
+    int *started = (int *)emalloc(numParts * sizeof(int));
+    size_t from = 0; int count = 0;
+
+    for (int i = 1; i <= numParts && from < size; i++) {
+        size_t target = size / numParts * i;
+        size_t to = i < numParts ? find_split(data, size, target > from ? target : from) : size;
+        if (to > from) {
+            parts[count].data = data + from;
+            parts[count].len = to - from;
+            count++;
+        }
+        from = to;
+    }
+    for (int i = 1; i < count; i++) {
+        started[i] = pthread_create(&threads[i], NULL, read_part, &parts[i]) == 0;
+    }
+    read_part(&parts[0]);
+    for (int i = 1; i < count; i++) {
+        if (started[i]) {
+            pthread_join(threads[i], NULL);
+        } else {
+            read_part(&parts[i]);
+        }
+    }
+
+    int ok = 1;
+    for (int i = 0; i < count; i++) {
+        if (parts[i].depth < 0 || (parts[i].depth != 0 && i < count - 1)) {
+            ok = 0;
+        }
+    }
+    for (int i = 0; i < count; i++) {
+        if (ok) {
+            table_append(table, parts[i].table);
+        }
+        table_free(parts[i].table);
+    }
+    free(started);
+    free(threads);
+    free(parts);
+    return ok;
+}
+
+/**
+ * Function: ics_read_file
+ * -----------------------
+ * @brief Reads the events of an ICS file, in parallel when it is large.
+ *
+ * A file of at least two ICS_SPLIT_SIZE bytes is mapped into memory, split on
+ * "BEGIN:VEVENT" lines into up to `threads` parts of about the same size, and
+ * the parts are read by as many threads (see read_parts()). The table is the
+ * one ics_read() gives, event for event, so the output does not depend on the
+ * number of threads; smaller files, files that cannot be mapped and files whose
+ * parts do not split cleanly are read sequentially.
+ *
+ * @param filename The path of the ICS file.
+ * @param table The table to store the extracted events in.
+ * @param threads The number of threads to use.
+ * @return int The number of events in the table, or -1 if the file cannot be opened.
+ *
+ */
+int ics_read_file(const char *filename, event_table_t *table, int threads) {
+    int fd = open(filename, O_RDONLY);
+    struct stat st;
+    if (fd < 0) {
+        return -1;
+    }
+
+    size_t size = fstat(fd, &st) == 0 && S_ISREG(st.st_mode) ? (size_t)st.st_size : 0;
+    size_t numParts = size / ICS_SPLIT_SIZE < (size_t)threads ? size / ICS_SPLIT_SIZE : (size_t)threads;
+    if (numParts >= 2) {
+        void *data = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (data != MAP_FAILED) {
+            int ok = read_parts((const char *)data, size, table, (int)numParts);
+            munmap(data, size);
+            if (ok) {
+                close(fd);
+                resolveZones(table);
+                return table->count;
+            }
+        }
+    }
+
+    FILE *ics = fdopen(fd, "r");
+    if (ics == NULL) {
+        close(fd);
+        return -1;
+    }
+    ics_read(ics, table);
+    fclose(ics);
+    return table->count;
+}
+
+/**
+ * Function: addEvent
+ * ------------------
+ * @brief Appends an event to the event table.
+ *
+ * @param table The event table.
+ * @param start The start of the event (see parse_timestamp()).
+ * @param end The end of the event.
+ * @param location The id of the location in the string pool of the table.
+ * @param summary The id of the summary in the string pool of the table.
+ * @param rule How the event repeats, or NULL if it does not.
+ * @param zone The id of the time zone of the event in the table, or -1 for floating times.
+ * @return void
+ *
+ */
+static void addEvent(event_table_t *table, long long start, long long end, int location, int summary,
+              const recurrence_t *rule, int zone) {
+    table_add(table, start, end, location, summary);
+    table->events[table->count - 1].zone = zone;
+    if (rule != NULL) {
+        table->events[table->count - 1].rule = table_add_rule(table, rule);
+    }
+}
+
+/**
+ * Function: addDates
+ * ------------------
+ * @brief Adds the EXDATEs and RDATEs of the event last added to the table.
+ *
+ * The EXDATEs go into the hash set of the table (see table_exclude()), where the
+ * occurrences of the event are looked up as they are generated, and the RDATEs
+ * are added as events of their own (see addRdate()). Both are taken in the time
+ * zone of the event, into which a date given in another zone (a TZID of its own,
+ * or UTC) has to be converted first; since the zones are only known once the
+ * whole file is read, all the dates of such an event are then kept in the table
+ * until resolveZones() adds them. The dates of an event with floating times are
+ * read as floating too, like its UNTIL.
+ *
+ * @param table The event table.
+ * @param exdates The EXDATEs of the event.
+ * @param rdates The RDATEs of the event.
+ * @return void
+ *
+ */
+static void addDates(event_table_t *table, const date_list_t *exdates, const date_list_t *rdates) {
+    int index = table->count - 1;
+    int zone = table->events[index].zone;
+    int defer = 0;
+
+    for (int i = 0; i < exdates->count + rdates->count; i++) {
+        const date_value_t *date = i < exdates->count ? &exdates->values[i] : &rdates->values[i - exdates->count];
+        defer = defer || (zone >= 0 && date->zone >= 0 && date->zone != zone);
+    }
+    for (int i = 0; i < exdates->count + rdates->count; i++) {
+        int rdate = i >= exdates->count;
+        const date_value_t *date = rdate ? &rdates->values[i - exdates->count] : &exdates->values[i];
+        if (defer) {
+            deferred_date_t deferred = {date->start, date->end, index, date->zone, rdate};
+            table_defer_date(table, &deferred);
+        } else if (rdate) {
+            addRdate(table, index, date->start, date->end);
+        } else {
+            table_exclude(table, index, date->start);
+        }
+    }
+}
+
+/**
+ * Function: addRdate
+ * ------------------
+ * @brief Adds an RDATE of an event, on the clock of the event, after its EXDATEs.
+ *
+ * The RDATE is added as an event of its own, unless it is the start of the event or
+ * an EXDATE cancels it: a period keeps its own end, and any other RDATE lasts as
+ * long as the event; one without a time starts at the time the event does.
+ *
+ * The recurrence set is a set (RFC 5545, section 3.8.5.2), so an RDATE also goes
+ * into the hash set of the event: an occurrence of the RRULE at the same time is
+ * dropped in favour of it, and the same RDATE given twice is only added once.
+ * Whether the RRULE has such an occurrence is then left to the lookup, which also
+ * holds for an UNTIL in UTC that is only put into the zone of the event once the
+ * whole file is read (see resolveZones()).
+ *
+ * @param table The event table.
+ * @param index The index of the event.
+ * @param start The RDATE (see date_value_t).
+ * @param end The end of its period, or 0.
+ * @return void
+ *
+ */
+static void addRdate(event_table_t *table, int index, long long start, long long end) {
+    event_t event = table->events[index];
+
+    if (start % 1000000 == 999999) {
+        start = start / 1000000 * 1000000 + event.start % 1000000;
+    }
+    if (start == event.start || table_is_excluded(table, index, start)) {
+        return;
+    }
+    table_exclude(table, index, start);
+    if (end == 0) {
+        end = seconds_to_timestamp(timestamp_to_seconds(start) + timestamp_to_seconds(event.end) -
+                                   timestamp_to_seconds(event.start));
+    }
+    table_add(table, start, end, event.location, event.summary);
+    table->events[table->count - 1].zone = event.zone;
+}
@@ -0,0 +1,19 @@
+/** @file ics_parse.h
+ *  @brief Function prototypes for reading the events of an iCalendar file into an event table.
+ *
+ */
+#ifndef _ICS_PARSE_H_
+#define _ICS_PARSE_H_
+
+#include <stdio.h>
+#include "event_table.h"
+
+/**
+ * @brief The smallest part of a file given to a thread of its own by ics_read_file().
+ */
+#define ICS_SPLIT_SIZE (1 << 20)
+
+int ics_read(FILE *ics, event_table_t *table);
+int ics_read_file(const char *filename, event_table_t *table, int threads);
+
+#endif
@@ -0,0 +1,177 @@
+/** @file intern.c
+ *  @brief Implementation of intern.h
+ *
+ */
+#include <stdlib.h>
+#include <string.h>
+#include "emalloc.h"
+#include "intern.h"
+
+/**
+ * Function: hash_string
+ * ---------------------
+ * @brief Computes the FNV-1a hash of a string.
+ *
+ * @param s The string.
+ * @param len The length of the string.
+ * @return size_t The hash of the string.
+ *
+ */
+static size_t hash_string(const char *s, size_t len) {
+    size_t hash = 2166136261u;
+
+    for (size_t i = 0; i < len; i++) {
+        hash ^= (unsigned char)s[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+/**
+ * Function: find_slot
+ * -------------------
+ * @brief Finds the hash table slot of a string, or the empty slot where it belongs.
+ *
+ * @param pool The string pool.
+ * @param s The string.
+ * @param len The length of the string.
+ * @return int The index of the slot.
+ *
+ */
+static int find_slot(const string_pool_t *pool, const char *s, size_t len) {
+    size_t mask = (size_t)pool->num_slots - 1;
+    size_t i = hash_string(s, len) & mask;
+
+    while (pool->slots[i] >= 0) {
+        const char *other = pool->text + pool->offsets[pool->slots[i]];
+        if (strncmp(other, s, len) == 0 && other[len] == '\0') {
+            break;
+        }
+        i = (i + 1) & mask;
+    }
+    return (int)i;
+}
+
+/**
+ * Function: grow_slots
+ * --------------------
+ * @brief Doubles the hash table and re-inserts every string.
+ *
+ * @param pool The string pool.
+ * @return void
+ *
+ */
+static void grow_slots(string_pool_t *pool) {
+    free(pool->slots);
+    pool->num_slots *= 2;
+    pool->slots = (int *)emalloc(pool->num_slots * sizeof(int));
+    memset(pool->slots, -1, pool->num_slots * sizeof(int));
+
+    for (int id = 0; id < pool->count; id++) {
+        const char *s = pool->text + pool->offsets[id];
+        pool->slots[find_slot(pool, s, strlen(s))] = id;
+    }
+}
+
+/**
+ * Function: pool_create
+ * ---------------------
+ * @brief Creates an empty string pool.
+ *
+ * @return string_pool_t* A pointer to the new pool.
+ *
+ */
+string_pool_t *pool_create(void) {
+    string_pool_t *pool = (string_pool_t *)emalloc(sizeof(string_pool_t));
+
+    pool->text_capacity = 1024;
+    pool->text = (char *)emalloc(pool->text_capacity);
+    pool->text_len = 0;
+    pool->capacity = 64;
+    pool->offsets = (size_t *)emalloc(pool->capacity * sizeof(size_t));
+    pool->count = 0;
+    pool->num_slots = 128;
+    pool->slots = (int *)emalloc(pool->num_slots * sizeof(int));
+    memset(pool->slots, -1, pool->num_slots * sizeof(int));
+    return pool;
+}
+
+/**
+ * Function: pool_intern
+ * ---------------------
+ * @brief Returns the id of a string, adding it to the pool if it is new.
+ *
+ * @param pool The string pool.
+ * @param s The string; it does not have to be NUL-terminated.
+ * @param len The length of the string.
+ * @return int The id of the string; equal strings always get the same id.
+ *
+ */
+int pool_intern(string_pool_t *pool, const char *s, size_t len) {
+    int slot = find_slot(pool, s, len);
+
+    if (pool->slots[slot] >= 0) {
+        return pool->slots[slot];
+    }
+
+    if (pool->text_len + len + 1 > pool->text_capacity) {
+        while (pool->text_len + len + 1 > pool->text_capacity) {
+            pool->text_capacity *= 2;
+        }
+        char *text = (char *)emalloc(pool->text_capacity);
+        memcpy(text, pool->text, pool->text_len);
+        free(pool->text);
+        pool->text = text;
+    }
+    if (pool->count == pool->capacity) {
+        size_t *offsets = (size_t *)emalloc(2 * pool->capacity * sizeof(size_t));
+        memcpy(offsets, pool->offsets, pool->count * sizeof(size_t));
+        free(pool->offsets);
+        pool->offsets = offsets;
+        pool->capacity *= 2;
+    }
+
+    memcpy(pool->text + pool->text_len, s, len);
+    pool->text[pool->text_len + len] = '\0';
+    pool->offsets[pool->count] = pool->text_len;
+    pool->text_len += len + 1;
+    pool->slots[slot] = pool->count++;
+
+    // Keep the table at most half full so probe sequences stay short.
+    if (2 * pool->count > pool->num_slots) {
+        grow_slots(pool);
+    }
+    return pool->count - 1;
+}
+
+/**
+ * Function: pool_get
+ * ------------------
+ * @brief Returns the string with the given id.
+ *
+ * The pointer is only valid until the next call to pool_intern().
+ *
+ * @param pool The string pool.
+ * @param id The id returned by pool_intern().
+ * @return const char* The NUL-terminated string.
+ *
+ */
+const char *pool_get(const string_pool_t *pool, int id) {
+    return pool->text + pool->offsets[id];
+}
+
+/**
+ * Function: pool_free
+ * -------------------
+ * @brief Frees a string pool and all its strings.
+ *
+ * @param pool The string pool.
+ * @return void
+ *
+ */
+void pool_free(string_pool_t *pool) {
+    free(pool->text);
+    free(pool->offsets);
+    free(pool->slots);
+    free(pool);
+}
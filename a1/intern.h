@@ -0,0 +1,33 @@
+/** @file intern.h
+ *  @brief Function prototypes for the string pool used to intern event text.
+ *
+ */
+#ifndef _INTERN_H_
+#define _INTERN_H_
+
+#include <stddef.h>
+
+/**
+ * @brief A pool that stores each distinct string once and names it by a small id.
+ *
+ * The strings are stored back to back, NUL-terminated, in one growable buffer;
+ * an open-addressing hash table maps the text of a string to its id. Events keep
+ * the ids, so a location or summary shared by many occurrences is stored once.
+ */
+typedef struct string_pool {
+    char *text;
+    size_t text_len;
+    size_t text_capacity;
+    size_t *offsets;
+    int count;
+    int capacity;
+    int *slots;
+    int num_slots;
+} string_pool_t;
+
+string_pool_t *pool_create(void);
+int pool_intern(string_pool_t *pool, const char *s, size_t len);
+const char *pool_get(const string_pool_t *pool, int id);
+void pool_free(string_pool_t *pool);
+
+#endif
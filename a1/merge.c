@@ -0,0 +1,129 @@
+/** @file merge.c
+ *  @brief Implementation of merge.h
+ *
+ */
+#include <stdlib.h>
+#include "emalloc.h"
+#include "merge.h"
+
+/**
+ * Function: comes_before
+ * ----------------------
+ * @brief Checks whether the next occurrence of one agenda comes before that of another.
+ *
+ * @param merge The merge.
+ * @param agenda1 The first agenda.
+ * @param agenda2 The second agenda.
+ * @return int 1 if the occurrence of agenda1 starts first (or at the same time, for an earlier agenda), 0 otherwise.
+ *
+ */
+static int comes_before(const merge_t *merge, int agenda1, int agenda2) {
+    long long start1 = merge->heads[agenda1].start;
+    long long start2 = merge->heads[agenda2].start;
+
+    return start1 < start2 || (start1 == start2 && agenda1 < agenda2);
+}
+
+/**
+ * Function: sift_down
+ * -------------------
+ * @brief Moves the agenda at a position of the heap down until neither child comes before it.
+ *
+ * @param merge The merge.
+ * @param i The position in the heap.
+ * @return void
+ *
+ */
+static void sift_down(merge_t *merge, int i) {
+    int *heap = merge->heap;
+
+    for (;;) {
+        int first = i;
+        int left = 2 * i + 1;
+        int right = left + 1;
+        if (left < merge->size && comes_before(merge, heap[left], heap[first])) {
+            first = left;
+        }
+        if (right < merge->size && comes_before(merge, heap[right], heap[first])) {
+            first = right;
+        }
+        if (first == i) {
+            return;
+        }
+        int agenda = heap[i];
+        heap[i] = heap[first];
+        heap[first] = agenda;
+        i = first;
+    }
+}
+
+/**
+ * Function: merge_create
+ * ----------------------
+ * @brief Starts merging agendas, reading the first occurrence of each.
+ *
+ * @param agendas The agendas; they must outlive the merge.
+ * @param num_agendas The number of agendas.
+ * @return merge_t* A pointer to the new merge.
+ *
+ */
+merge_t *merge_create(agenda_t **agendas, int num_agendas) {
+    merge_t *merge = (merge_t *)emalloc(sizeof(merge_t));
+    size_t n = num_agendas > 0 ? num_agendas : 1;
+
+    merge->agendas = agendas;
+    merge->num_agendas = num_agendas;
+    merge->heads = (event_t *)emalloc(n * sizeof(event_t));
+    merge->heap = (int *)emalloc(n * sizeof(int));
+    merge->size = 0;
+    for (int i = 0; i < num_agendas; i++) {
+        if (agenda_next(agendas[i], &merge->heads[i])) {
+            merge->heap[merge->size++] = i;
+        }
+    }
+    for (int i = merge->size / 2 - 1; i >= 0; i--) {
+        sift_down(merge, i);
+    }
+    return merge;
+}
+
+/**
+ * Function: merge_next
+ * --------------------
+ * @brief Gets the next occurrence of the merged agendas.
+ *
+ * @param merge The merge.
+ * @param occurrence Set to the next occurrence; it shares the strings of its event.
+ * @param agenda Set to the agenda the occurrence comes from.
+ * @return int 1 if there was another occurrence, 0 once every agenda is exhausted.
+ *
+ */
+int merge_next(merge_t *merge, event_t *occurrence, int *agenda) {
+    if (merge->size == 0) {
+        return 0;
+    }
+
+    int first = merge->heap[0];
+    *occurrence = merge->heads[first];
+    *agenda = first;
+    if (!agenda_next(merge->agendas[first], &merge->heads[first])) {
+        merge->heap[0] = merge->heap[--merge->size];
+    }
+    sift_down(merge, 0);
+    return 1;
+}
+
+/**
+ * Function: merge_free
+ * --------------------
+ * @brief Frees a merge; the agendas are left alone.
+ *
+ * @param merge The merge.
+ * @return void
+ *
+ */
+void merge_free(merge_t *merge) {
+    free(merge->heads);
+    free(merge->heap);
+    free(merge);
+}
@@ -0,0 +1,29 @@
+/** @file merge.h
+ *  @brief Function prototypes for the k-way merge of the agendas of several calendars.
+ *
+ */
+#ifndef _MERGE_H_
+#define _MERGE_H_
+
+#include "agenda.h"
+
+/**
+ * @brief A k-way merge of agendas into one chronological stream of occurrences.
+ *
+ * `heads` holds the next occurrence of each agenda, and `heap` is a min-heap of
+ * the agendas that have one, by start (then by agenda, so ties keep the order
+ * the calendars were given in). The agendas are not owned by the merge.
+ */
+typedef struct merge {
+    agenda_t **agendas;
+    int num_agendas;
+    event_t *heads;
+    int *heap;
+    int size;
+} merge_t;
+
+merge_t *merge_create(agenda_t **agendas, int num_agendas);
+int merge_next(merge_t *merge, event_t *occurrence, int *agenda);
+void merge_free(merge_t *merge);
+
+#endif
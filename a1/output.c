@@ -0,0 +1,376 @@
+/** @file output.c
+ *  @brief Implementation of output.h
+ *
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "emalloc.h"
+#include "output.h"
+
+/**
+ * @brief The dashes under a date line, which is never longer than this.
+ */
+static const char dashes[] = "----------------------------------------------";
+
+/**
+ * @brief The names of the months, from 1.
+ */
+static const char *monthNames[] = {"", "January", "February", "March", "April", "May", "June",
+                                   "July", "August", "September", "October", "November", "December"};
+
+/**
+ * @brief The longest date put_date() writes.
+ */
+#define MAX_DATE_LEN 32
+
+/**
+ * Function: output_open
+ * ---------------------
+ * @brief Creates an output writing to a file, or keeping its text in memory.
+ *
+ * @param file The file to write to, or NULL to keep the text in the buffer.
+ * @return output_t* A pointer to the new output.
+ *
+ */
+output_t *output_open(FILE *file) {
+    output_t *out = (output_t *)emalloc(sizeof(output_t));
+
+    out->file = file;
+    out->capacity = file != NULL ? OUTPUT_BLOCK_SIZE : 256;
+    out->buffer = (char *)emalloc(out->capacity);
+    out->len = 0;
+    return out;
+}
+
+/**
+ * Function: reserve
+ * -----------------
+ * @brief Makes room for `len` more bytes in the buffer of an output.
+ *
+ * An output with a file writes out what it holds first; the buffer only grows
+ * when a single piece of text is larger than it, or when there is no file.
+ *
+ * @param out The output.
+ * @param len The number of bytes about to be written.
+ * @return char* Where to write them.
+ *
+ */
+static char *reserve(output_t *out, size_t len) {
+    if (out->len + len > out->capacity && out->file != NULL) {
+        output_flush(out);
+    }
+    if (out->len + len > out->capacity) {
+        size_t capacity = 2 * out->capacity;
+        while (out->len + len > capacity) {
+            capacity *= 2;
+        }
+        char *buffer = (char *)emalloc(capacity);
+        memcpy(buffer, out->buffer, out->len);
+        free(out->buffer);
+        out->buffer = buffer;
+        out->capacity = capacity;
+    }
+    return out->buffer + out->len;
+}
+
+/**
+ * Function: commit
+ * ----------------
+ * @brief Ends a write into the space given by reserve(), writing out a full block.
+ *
+ * @param out The output.
+ * @param end The end of the text written.
+ * @return void
+ *
+ */
+static void commit(output_t *out, char *end) {
+    out->len = end - out->buffer;
+    if (out->file != NULL && out->len >= OUTPUT_BLOCK_SIZE) {
+        output_flush(out);
+    }
+}
+
+/**
+ * Function: put_2d
+ * ----------------
+ * @brief Writes a number from 0 to 99 in two characters, padded with `pad`.
+ *
+ * @param p Where to write.
+ * @param value The number.
+ * @param pad The padding of a number below 10: ' ' (as "%2d") or '0' (as "%02d").
+ * @return char* The end of the text written.
+ *
+ */
+static char *put_2d(char *p, int value, char pad) {
+    *p++ = value >= 10 ? (char)('0' + value / 10) : pad;
+    *p++ = (char)('0' + value % 10);
+    return p;
+}
+
+/**
+ * Function: put_int
+ * -----------------
+ * @brief Writes an integer in decimal, as "%d".
+ *
+ * @param p Where to write (at least 11 characters).
+ * @param value The integer.
+ * @return char* The end of the text written.
+ *
+ */
+static char *put_int(char *p, int value) {
+    char digits[10]; int n = 0;
+    unsigned int magnitude = value < 0 ? 0u - (unsigned int)value : (unsigned int)value;
+
+    if (value < 0) {
+        *p++ = '-';
+    }
+    do {
+        digits[n++] = (char)('0' + magnitude % 10);
+        magnitude /= 10;
+    } while (magnitude > 0);
+    while (n > 0) {
+        *p++ = digits[--n];
+    }
+    return p;
+}
+
+/**
+ * Function: put_time
+ * ------------------
+ * @brief Writes the time of a timestamp on the 12-hour clock, as "%2d:%02d %s".
+ *
+ * Hours after noon are counted from 12, so 13:05 is " 1:05 PM", while 12:30 is
+ * "12:30 PM" and 00:30 is " 0:30 AM".
+ *
+ * @param p Where to write (8 characters).
+ * @param timestamp The timestamp (YYYYMMDDhhmmss).
+ * @return char* The end of the text written.
+ *
+ */
+static char *put_time(char *p, long long timestamp) {
+    int hour = (int)(timestamp / 10000 % 100); int minute = (int)(timestamp / 100 % 100);
+
+    p = put_2d(p, hour > 12 ? hour - 12 : hour, ' ');
+    *p++ = ':';
+    p = put_2d(p, minute, '0');
+    *p++ = ' ';
+    *p++ = hour >= 12 ? 'P' : 'A';
+    *p++ = 'M';
+    return p;
+}
+
+/**
+ * Function: put_date
+ * ------------------
+ * @brief Writes a date as "%s %02d, %d", e.g. "June 01, 2023".
+ *
+ * @param p Where to write (MAX_DATE_LEN characters).
+ * @param date The date (YYYYMMDD).
+ * @return char* The end of the text written.
+ *
+ */
+static char *put_date(char *p, long long date) {
+    int year = (int)(date / 10000); int month = (int)(date / 100 % 100); int day = (int)(date % 100);
+    const char *name = month >= 1 && month <= 12 ? monthNames[month] : "";
+    size_t nameLen = strlen(name);
+
+    memcpy(p, name, nameLen);
+    p += nameLen;
+    *p++ = ' ';
+    p = put_2d(p, day, '0');
+    *p++ = ',';
+    *p++ = ' ';
+    return put_int(p, year);
+}
+
+/**
+ * Function: output_write
+ * ----------------------
+ * @brief Writes text as is.
+ *
+ * @param out The output.
+ * @param text The text.
+ * @param len The length of the text.
+ * @return void
+ *
+ */
+void output_write(output_t *out, const char *text, size_t len) {
+    char *p = reserve(out, len);
+
+    memcpy(p, text, len);
+    commit(out, p + len);
+}
+
+/**
+ * Function: output_append
+ * -----------------------
+ * @brief Writes the text kept by an output without a file.
+ *
+ * @param out The output.
+ * @param other The output whose text to write.
+ * @return void
+ *
+ */
+void output_append(output_t *out, const output_t *other) {
+    output_write(out, other->buffer, other->len);
+}
+
+/**
+ * Function: output_day
+ * --------------------
+ * @brief Writes the date line of a day and the dashes under it.
+ *
+ * For example: output_day(out, 20230601) writes "June 01, 2023\n-------------\n".
+ *
+ * @param out The output.
+ * @param date The date (YYYYMMDD).
+ * @return void
+ *
+ */
+void output_day(output_t *out, long long date) {
+    char *p = reserve(out, 2 * MAX_DATE_LEN + 2);
+    char *line = p;
+
+    p = put_date(p, date);
+    size_t lineLen = p - line;
+    if (lineLen > sizeof(dashes) - 1) {
+        lineLen = sizeof(dashes) - 1;
+    }
+    *p++ = '\n';
+    memcpy(p, dashes, lineLen);
+    p += lineLen;
+    *p++ = '\n';
+    commit(out, p);
+}
+
+/**
+ * Function: output_event
+ * ----------------------
+ * @brief Writes the line of an event: its times, summary and location.
+ *
+ * For example: " 8:00 AM to  3:00 PM: Clean apartment {{Flouncy Towers}}\n".
+ *
+ * @param out The output.
+ * @param event The event.
+ * @param strings The string pool holding the location and summary of the event.
+ * @return void
+ *
+ */
+void output_event(output_t *out, const event_t *event, const string_pool_t *strings) {
+    const char *summary = pool_get(strings, event->summary);
+    const char *location = pool_get(strings, event->location);
+    size_t summaryLen = strlen(summary); size_t locationLen = strlen(location);
+    char *p = reserve(out, summaryLen + locationLen + 32);
+
+    p = put_time(p, event->start);
+    memcpy(p, " to ", 4);
+    p = put_time(p + 4, event->end);
+    *p++ = ':';
+    *p++ = ' ';
+    memcpy(p, summary, summaryLen);
+    p += summaryLen;
+    memcpy(p, " {{", 3);
+    p += 3;
+    memcpy(p, location, locationLen);
+    p += locationLen;
+    memcpy(p, "}}\n", 3);
+    commit(out, p + 3);
+}
+
+/**
+ * Function: output_overlap
+ * ------------------------
+ * @brief Writes the line of an event that another one overlaps, under the line of the latter.
+ *
+ * For example: "    same location:  9:00 AM to 10:00 AM: Review {{ECS 123}}\n". An
+ * event that starts on another day than the one it overlaps gives its date first:
+ * "    same calendar: March 01, 2023  9:00 PM to  1:00 AM: Party {{Home}}\n".
+ *
+ * @param out The output.
+ * @param reason Why the events conflict, e.g. "same location".
+ * @param event The event.
+ * @param strings The string pool holding the location and summary of the event.
+ * @param withDate Whether to give the date of the event.
+ * @return void
+ *
+ */
+void output_overlap(output_t *out, const char *reason, const event_t *event, const string_pool_t *strings,
+                    int withDate) {
+    size_t reasonLen = strlen(reason);
+    char *p = reserve(out, reasonLen + MAX_DATE_LEN + 8);
+
+    memcpy(p, "    ", 4);
+    memcpy(p + 4, reason, reasonLen);
+    p += 4 + reasonLen;
+    *p++ = ':';
+    *p++ = ' ';
+    if (withDate) {
+        p = put_date(p, event->start / 1000000);
+        *p++ = ' ';
+    }
+    commit(out, p);
+    output_event(out, event, strings);
+}
+
+/**
+ * Function: output_busy
+ * ---------------------
+ * @brief Writes the line of a busy block.
+ *
+ * For example: " 8:00 AM to  3:00 PM: busy\n". A block that ends on a later day
+ * than it starts gives the day it ends: " 9:00 PM to  1:00 AM: busy until
+ * June 02, 2023\n".
+ *
+ * @param out The output.
+ * @param start The start of the block (YYYYMMDDhhmmss).
+ * @param end The end of the block.
+ * @return void
+ *
+ */
+void output_busy(output_t *out, long long start, long long end) {
+    char *p = reserve(out, 32 + MAX_DATE_LEN);
+
+    p = put_time(p, start);
+    memcpy(p, " to ", 4);
+    p = put_time(p + 4, end);
+    memcpy(p, ": busy", 6);
+    p += 6;
+    if (end / 1000000 != start / 1000000) {
+        memcpy(p, " until ", 7);
+        p = put_date(p + 7, end / 1000000);
+    }
+    *p++ = '\n';
+    commit(out, p);
+}
+
+/**
+ * Function: output_flush
+ * ----------------------
+ * @brief Writes the buffered text of an output to its file.
+ *
+ * @param out The output.
+ * @return void
+ *
+ */
+void output_flush(output_t *out) {
+    if (out->file != NULL && out->len > 0) {
+        fwrite(out->buffer, 1, out->len, out->file);
+        out->len = 0;
+    }
+}
+
+/**
+ * Function: output_close
+ * ----------------------
+ * @brief Flushes and frees an output; its file is left open.
+ *
+ * @param out The output.
+ * @return void
+ *
+ */
+void output_close(output_t *out) {
+    output_flush(out);
+    free(out->buffer);
+    free(out);
+}
@@ -0,0 +1,43 @@
+/** @file output.h
+ *  @brief Function prototypes for the buffered writer of the agenda.
+ *
+ */
+#ifndef _OUTPUT_H_
+#define _OUTPUT_H_
+
+#include <stdio.h>
+#include "event_table.h"
+
+/**
+ * @brief The size of the blocks an output writes its file in.
+ */
+#define OUTPUT_BLOCK_SIZE (1 << 16)
+
+/**
+ * @brief A writer that formats the agenda into a buffer of its own.
+ *
+ * The text is appended to `buffer` and written to `file` in blocks of
+ * OUTPUT_BLOCK_SIZE bytes, so stdio only ever sees large writes and no format
+ * strings. An output without a file (`file` is NULL) keeps all of its text in
+ * the buffer, which grows as needed, until it is copied elsewhere with
+ * output_append().
+ */
+typedef struct output {
+    FILE *file;
+    char *buffer;
+    size_t len;
+    size_t capacity;
+} output_t;
+
+output_t *output_open(FILE *file);
+void output_write(output_t *out, const char *text, size_t len);
+void output_append(output_t *out, const output_t *other);
+void output_day(output_t *out, long long date);
+void output_event(output_t *out, const event_t *event, const string_pool_t *strings);
+void output_overlap(output_t *out, const char *reason, const event_t *event, const string_pool_t *strings,
+                    int withDate);
+void output_busy(output_t *out, long long start, long long end);
+void output_flush(output_t *out);
+void output_close(output_t *out);
+
+#endif
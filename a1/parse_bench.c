@@ -0,0 +1,148 @@
+/** @file parse_bench.c
+ *  @brief A benchmark of reading one large ICS file with more and more threads.
+ *
+ * A synthetic calendar (events of varied length, a tenth of them recurring,
+ * some with an alarm and some with a folded summary) is written to a temporary
+ * file, then read with ics_read_file() by 1, 2, 4 and 8 threads. Each read is
+ * timed over several runs; the best run is reported, with the speedup over one
+ * thread, and every table is checked to hold the same events, rules and
+ * strings as the one read sequentially.
+ *
+ * Usage: ./parse_bench [EVENTS] [RUNS]
+ *
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "event_table.h"
+#include "ics_parse.h"
+
+/**
+ * @brief Get the current time in seconds from a monotonic clock.
+ */
+static double now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/**
+ * @brief Write a calendar of `count` events to `file`.
+ */
+static void write_calendar(FILE *file, int count)
+{
+    unsigned int seed = 12345;
+
+    fprintf(file, "BEGIN:VCALENDAR\r\nVERSION:2.0\r\nPRODID:-//parse_bench//EN\r\n");
+    for (int i = 0; i < count; i++) {
+        seed = seed * 1103515245 + 12345;
+        int year = 2020 + seed % 7;
+        int month = 1 + (seed >> 8) % 12;
+        int day = 1 + (seed >> 12) % 28;
+        int hour = (seed >> 16) % 21;
+        int length = 1 + (seed >> 24) % 3;
+        fprintf(file, "BEGIN:VEVENT\r\nUID:event-%d@parse-bench\r\n", i);
+        fprintf(file, "DTSTART:%04d%02d%02dT%02d0000\r\n", year, month, day, hour);
+        fprintf(file, "DTEND:%04d%02d%02dT%02d3000\r\n", year, month, day, hour + length);
+        if (i % 10 == 0) {
+            fprintf(file, "RRULE:FREQ=WEEKLY;COUNT=%d;BYDAY=MO,WE\r\n", 2 + i % 50);
+        }
+        if (i % 7 == 0) {
+            fprintf(file, "SUMMARY:A meeting with a summary long enough to be folded acros\r\n s two lines %d\r\n", i % 500);
+        } else {
+            fprintf(file, "SUMMARY:Meeting %d\r\n", i % 1000);
+        }
+        fprintf(file, "LOCATION:Room %d\r\n", i % 97);
+        if (i % 5 == 0) {
+            fprintf(file, "BEGIN:VALARM\r\nACTION:DISPLAY\r\nTRIGGER:-PT15M\r\nEND:VALARM\r\n");
+        }
+        fprintf(file, "END:VEVENT\r\n");
+    }
+    fprintf(file, "END:VCALENDAR\r\n");
+}
+
+/**
+ * @brief Check that two tables hold the same events, rules and strings.
+ */
+static int same_table(const event_table_t *a, const event_table_t *b)
+{
+    if (a->count != b->count || a->num_rules != b->num_rules || a->strings->count != b->strings->count) {
+        return 0;
+    }
+    for (int i = 0; i < a->count; i++) {
+        const event_t *x = &a->events[i]; const event_t *y = &b->events[i];
+        if (x->start != y->start || x->end != y->end || x->location != y->location ||
+            x->summary != y->summary || x->rule != y->rule) {
+            return 0;
+        }
+    }
+    for (int i = 0; i < a->strings->count; i++) {
+        if (strcmp(pool_get(a->strings, i), pool_get(b->strings, i)) != 0) {
+            return 0;
+        }
+    }
+    return memcmp(a->rules, b->rules, a->num_rules * sizeof(recurrence_t)) == 0;
+}
+
+/**
+ * @brief The main function and entry point of the benchmark.
+ *
+ * @param argc The number of arguments passed to the program.
+ * @param argv The list of arguments passed to the program.
+ * @return int 0: No errors; 1: Errors produced.
+ *
+ */
+int main(int argc, char *argv[])
+{
+    static const int threads[] = {1, 2, 4, 8};
+    int count = argc > 1 ? atoi(argv[1]) : 1000000;
+    int runs = argc > 2 ? atoi(argv[2]) : 3;
+    char path[] = "/tmp/parse_bench_XXXXXX";
+    int fd = mkstemp(path);
+    FILE *file = fd >= 0 ? fdopen(fd, "w") : NULL;
+    event_table_t *expected = NULL;
+    double base = 0;
+
+    if (file == NULL) {
+        printf("unable to create a temporary file\n");
+        return 1;
+    }
+    write_calendar(file, count);
+    fclose(file);
+    printf("%ld processors\n", sysconf(_SC_NPROCESSORS_ONLN));
+
+    for (size_t t = 0; t < sizeof(threads) / sizeof(threads[0]); t++) {
+        double best = -1;
+        for (int i = 0; i < runs; i++) {
+            event_table_t *table = table_create();
+            double start = now();
+            ics_read_file(path, table, threads[t]);
+            double elapsed = now() - start;
+            if (best < 0 || elapsed < best) {
+                best = elapsed;
+            }
+            if (expected == NULL) {
+                expected = table;
+            } else if (!same_table(expected, table)) {
+                printf("%d threads disagree with 1 thread\n", threads[t]);
+                unlink(path);
+                return 1;
+            } else {
+                table_free(table);
+            }
+        }
+        if (t == 0) {
+            base = best;
+        }
+        printf("%d threads  %8.2f ms  %8.2f ns/event  %8d events  speedup %5.2fx\n",
+               threads[t], best * 1e3, best * 1e9 / count, expected->count, base / best);
+    }
+
+    table_free(expected);
+    unlink(path);
+    return 0;
+}
@@ -0,0 +1,688 @@
+/** @file rrule.c
+ *  @brief Implementation of rrule.h
+ *
+ * Every date is handled as a day number (see date.h), so stepping through days,
+ * weeks, months and years is integer arithmetic. Only the FREQ values that step
+ * by whole days are supported; an RRULE with FREQ=HOURLY or finer is ignored.
+ *
+ */
+#include <stdlib.h>
+#include <string.h>
+#include "date.h"
+#include "rrule.h"
+
+/**
+ * @brief The two-letter names of the weekdays, from Monday.
+ */
+static const char *weekdayNames[] = {"MO", "TU", "WE", "TH", "FR", "SA", "SU"};
+
+/**
+ * Function: floor_div
+ * -------------------
+ * @brief Divides two integers, rounding towards negative infinity.
+ *
+ * @param a The dividend.
+ * @param b The divisor; it must be positive.
+ * @return long The floor of a / b.
+ *
+ */
+static long floor_div(long a, long b) {
+    return a >= 0 ? a / b : -((-a + b - 1) / b);
+}
+
+/**
+ * Function: weekday
+ * -----------------
+ * @brief Gets the weekday of a day number (1970-01-01 was a Thursday).
+ *
+ * @param day The day number.
+ * @return int The weekday, from 0 (Monday) to 6 (Sunday).
+ *
+ */
+static int weekday(long day) {
+    return (int)(day + 3 - floor_div(day + 3, 7) * 7);
+}
+
+/**
+ * Function: days_in_month
+ * -----------------------
+ * @brief Gets the number of days in a month.
+ *
+ * @param year The year.
+ * @param month The month, from 1 to 12.
+ * @return int The number of days in the month.
+ *
+ */
+static int days_in_month(int year, int month) {
+    return (int)(days_from_civil(month == 12 ? year + 1 : year, month == 12 ? 1 : month + 1, 1) -
+                 days_from_civil(year, month, 1));
+}
+
+/**
+ * Function: week_start
+ * --------------------
+ * @brief Gets the first day of the week holding a day.
+ *
+ * @param day The day number.
+ * @param wkst The weekday weeks start on.
+ * @return long The day number of the start of the week.
+ *
+ */
+static long week_start(long day, int wkst) {
+    return day - (weekday(day) - wkst + 7) % 7;
+}
+
+/**
+ * Function: parse_weekday
+ * -----------------------
+ * @brief Parses a two-letter weekday name.
+ *
+ * @param text The name, e.g. "MO".
+ * @return int The weekday, from 0 (Monday) to 6 (Sunday), or -1 if it is not a weekday.
+ *
+ */
+static int parse_weekday(const char *text) {
+    for (int i = 0; i < 7; i++) {
+        if (strncmp(text, weekdayNames[i], 2) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+/**
+ * Function: parse_byday
+ * ---------------------
+ * @brief Parses the value of BYDAY, e.g. "MO,WE" or "2TU,-1FR", into the rule.
+ *
+ * Ordinals beyond the 5th (only meaningful for yearly rules) are ignored.
+ *
+ * @param value The value, ending at ';' or the end of the line.
+ * @param rule The rule to fill in.
+ * @return void
+ *
+ */
+static void parse_byday(const char *value, recurrence_t *rule) {
+    while (*value != '\0' && *value != ';' && *value != '\r' && *value != '\n') {
+        char *rest;
+        long nth = strtol(value, &rest, 10);
+        int day = parse_weekday(rest);
+        if (day >= 0) {
+            if (nth == 0) {
+                rule->byday[day] |= 1;
+            } else if (nth >= 1 && nth <= 5) {
+                rule->byday[day] |= 1 << nth;
+            } else if (nth <= -1 && nth >= -5) {
+                rule->byday[day] |= 1 << (5 - nth);
+            }
+        }
+        value += strcspn(value, ",;\r\n");
+        if (*value == ',') {
+            value++;
+        }
+    }
+}
+
+/**
+ * Function: parse_bymonthday
+ * --------------------------
+ * @brief Parses the value of BYMONTHDAY, e.g. "1,15,-1", into the rule.
+ *
+ * @param value The value, ending at ';' or the end of the line.
+ * @param rule The rule to fill in.
+ * @return void
+ *
+ */
+static void parse_bymonthday(const char *value, recurrence_t *rule) {
+    while (*value != '\0' && *value != ';' && *value != '\r' && *value != '\n') {
+        long day = strtol(value, NULL, 10);
+        if (day >= 1 && day <= 31) {
+            rule->bymonthday |= 1ULL << day;
+        } else if (day <= -1 && day >= -31) {
+            rule->bymonthday |= 1ULL << (32 - day);
+        }
+        value += strcspn(value, ",;\r\n");
+        if (*value == ',') {
+            value++;
+        }
+    }
+}
+
+/**
+ * Function: parse_bymonth
+ * -----------------------
+ * @brief Parses the value of BYMONTH, e.g. "3,11", into the rule.
+ *
+ * @param value The value, ending at ';' or the end of the line.
+ * @param rule The rule to fill in.
+ * @return void
+ *
+ */
+static void parse_bymonth(const char *value, recurrence_t *rule) {
+    while (*value != '\0' && *value != ';' && *value != '\r' && *value != '\n') {
+        long month = strtol(value, NULL, 10);
+        if (month >= 1 && month <= 12) {
+            rule->bymonth |= 1 << month;
+        }
+        value += strcspn(value, ",;\r\n");
+        if (*value == ',') {
+            value++;
+        }
+    }
+}
+
+/**
+ * Function: parse_rrule
+ * ---------------------
+ * @brief Parses an RRULE line into a recurrence rule.
+ *
+ * The FREQ, INTERVAL, COUNT, UNTIL, BYDAY, BYMONTHDAY, BYMONTH and WKST parts are read;
+ * any other part is ignored. An UNTIL date without a time covers that whole day, and
+ * one in UTC (ending in 'Z') sets `until_utc`, for the reader to convert it into the
+ * time zone of the event.
+ * For example: "RRULE:FREQ=WEEKLY;UNTIL=20230630T235959;BYDAY=WE".
+ *
+ * @param line The RRULE line.
+ * @param rule The rule to fill in.
+ * @return int 1 if the rule is supported, 0 if it has no FREQ or one finer than DAILY.
+ *
+ */
+int parse_rrule(const char *line, recurrence_t *rule) {
+    const char *part = strchr(line, ':');
+    int supported = 0;
+
+    memset(rule, 0, sizeof(recurrence_t));
+    rule->interval = 1;
+    part = part != NULL ? part + 1 : line;
+
+    while (*part != '\0' && *part != '\r' && *part != '\n') {
+        const char *value = strchr(part, '=');
+        size_t nameLength = strcspn(part, "=;\r\n");
+        if (value == NULL || value != part + nameLength) {
+            break;
+        }
+        value++;
+
+        if (strncmp(part, "FREQ", nameLength) == 0 && nameLength == 4) {
+            static const char *freqNames[] = {"DAILY", "WEEKLY", "MONTHLY", "YEARLY"};
+            for (int i = 0; i < 4; i++) {
+                size_t length = strlen(freqNames[i]);
+                if (strncmp(value, freqNames[i], length) == 0 && strchr(";\r\n", value[length]) != NULL) {
+                    rule->freq = (frequency_t)i;
+                    supported = 1;
+                }
+            }
+        } else if (strncmp(part, "INTERVAL", nameLength) == 0 && nameLength == 8) {
+            rule->interval = atoi(value) > 0 ? atoi(value) : 1;
+        } else if (strncmp(part, "COUNT", nameLength) == 0 && nameLength == 5) {
+            rule->count = atoi(value) > 0 ? atoi(value) : 0;
+        } else if (strncmp(part, "UNTIL", nameLength) == 0 && nameLength == 5) {
+            rule->until = parse_timestamp(value);
+            if (value[8] != 'T') {
+                rule->until += 235959;
+            } else {
+                rule->until_utc = strcspn(value, ";\r\n") > 15 && value[15] == 'Z';
+            }
+        } else if (strncmp(part, "BYDAY", nameLength) == 0 && nameLength == 5) {
+            parse_byday(value, rule);
+        } else if (strncmp(part, "BYMONTHDAY", nameLength) == 0 && nameLength == 10) {
+            parse_bymonthday(value, rule);
+        } else if (strncmp(part, "BYMONTH", nameLength) == 0 && nameLength == 7) {
+            parse_bymonth(value, rule);
+        } else if (strncmp(part, "WKST", nameLength) == 0 && nameLength == 4) {
+            rule->wkst = parse_weekday(value) >= 0 ? parse_weekday(value) : 0;
+        }
+
+        part = value + strcspn(value, ";\r\n");
+        if (*part == ';') {
+            part++;
+        }
+    }
+    return supported;
+}
+
+/**
+ * Function: matches_byday
+ * -----------------------
+ * @brief Checks a day against the BYDAY part of a rule.
+ *
+ * @param rule The rule.
+ * @param day The day number.
+ * @param nth Which one of its weekday the day is in the period, counting from 1.
+ * @param nthLast Which one of its weekday the day is in the period, counting from the end.
+ * @return int 1 if the day matches, 0 otherwise.
+ *
+ */
+static int matches_byday(const recurrence_t *rule, long day, int nth, int nthLast) {
+    unsigned int bits = rule->byday[weekday(day)];
+
+    return (bits & 1) || (nth <= 5 && (bits >> nth) & 1) || (nthLast <= 5 && (bits >> (5 + nthLast)) & 1);
+}
+
+/**
+ * Function: matches_bymonthday
+ * ----------------------------
+ * @brief Checks a day of the month against the BYMONTHDAY part of a rule.
+ *
+ * @param rule The rule.
+ * @param day The day of the month.
+ * @param length The number of days in the month.
+ * @return int 1 if the day matches, 0 otherwise.
+ *
+ */
+static int matches_bymonthday(const recurrence_t *rule, int day, int length) {
+    return ((rule->bymonthday >> day) & 1) || ((rule->bymonthday >> (32 + length + 1 - day)) & 1);
+}
+
+/**
+ * Function: period_start
+ * ----------------------
+ * @brief Gets the first day of period p of a rule (period 0 holds the first occurrence).
+ *
+ * @param rule The rule.
+ * @param firstDay The day number of the first occurrence.
+ * @param p The period.
+ * @return long The day number the period starts on.
+ *
+ */
+static long period_start(const recurrence_t *rule, long firstDay, long p) {
+    int year, month, day;
+
+    civil_from_days(firstDay, &year, &month, &day);
+    switch (rule->freq) {
+    case FREQ_DAILY:
+        return firstDay + p * rule->interval;
+    case FREQ_WEEKLY:
+        return week_start(firstDay, rule->wkst) + 7 * p * rule->interval;
+    case FREQ_MONTHLY: {
+        long index = year * 12L + month - 1 + p * rule->interval;
+        return days_from_civil((int)floor_div(index, 12), (int)(index - floor_div(index, 12) * 12) + 1, 1);
+    }
+    default:
+        return days_from_civil((int)(year + p * rule->interval), 1, 1);
+    }
+}
+
+/**
+ * Function: period_of
+ * -------------------
+ * @brief Gets the period of a rule that holds a day.
+ *
+ * @param rule The rule.
+ * @param firstDay The day number of the first occurrence.
+ * @param day The day number.
+ * @return long The period holding the day; it is negative before the first occurrence.
+ *
+ */
+static long period_of(const recurrence_t *rule, long firstDay, long day) {
+    int year0, month0, day0, year, month, dayOfMonth;
+
+    civil_from_days(firstDay, &year0, &month0, &day0);
+    civil_from_days(day, &year, &month, &dayOfMonth);
+    switch (rule->freq) {
+    case FREQ_DAILY:
+        return floor_div(day - firstDay, rule->interval);
+    case FREQ_WEEKLY:
+        return floor_div(week_start(day, rule->wkst) - week_start(firstDay, rule->wkst), 7L * rule->interval);
+    case FREQ_MONTHLY:
+        return floor_div((year - year0) * 12L + month - month0, rule->interval);
+    default:
+        return floor_div(year - year0, rule->interval);
+    }
+}
+
+/**
+ * Function: day_matches
+ * ---------------------
+ * @brief Checks whether a day of the period of a rule that holds it is an occurrence.
+ *
+ * Without BYDAY and BYMONTHDAY, the period holds the day matching the first
+ * occurrence: the same weekday, day of the month or date. With them, the monthly
+ * and yearly rules use them to pick days, while the daily and weekly rules use
+ * BYMONTHDAY to filter days. BYMONTH filters the days of every rule; a yearly
+ * rule with BYMONTH repeats in each of the months, and counts the weekdays of
+ * BYDAY within the month (e.g. BYMONTH=3;BYDAY=2SU for the second Sunday of March).
+ *
+ * @param rule The rule.
+ * @param byday Whether to apply BYDAY.
+ * @param bymonthday Whether to apply BYMONTHDAY.
+ * @param bymonth Whether to apply BYMONTH.
+ * @param firstDay The day number of the first occurrence.
+ * @param day The day number.
+ * @return int 1 if the day is an occurrence, 0 otherwise.
+ *
+ */
+static int day_matches(const recurrence_t *rule, int byday, int bymonthday, int bymonth, long firstDay, long day) {
+    int year0, month0, day0, year, month, dayOfMonth;
+
+    civil_from_days(firstDay, &year0, &month0, &day0);
+    civil_from_days(day, &year, &month, &dayOfMonth);
+    int length = days_in_month(year, month);
+    if (bymonthday && !matches_bymonthday(rule, dayOfMonth, length)) {
+        return 0;
+    }
+    if (bymonth && !((rule->bymonth >> month) & 1)) {
+        return 0;
+    }
+
+    switch (rule->freq) {
+    case FREQ_DAILY:
+        return !byday || rule->byday[weekday(day)] != 0;
+    case FREQ_WEEKLY:
+        return byday ? rule->byday[weekday(day)] != 0 : weekday(day) == weekday(firstDay);
+    case FREQ_MONTHLY:
+        if (byday) {
+            return matches_byday(rule, day, (dayOfMonth - 1) / 7 + 1, (length - dayOfMonth) / 7 + 1);
+        }
+        return bymonthday || dayOfMonth == day0;
+    default:
+        if (byday && bymonth) {
+            return matches_byday(rule, day, (dayOfMonth - 1) / 7 + 1, (length - dayOfMonth) / 7 + 1);
+        }
+        if (byday) {
+            long start = days_from_civil(year, 1, 1);
+            long end = days_from_civil(year + 1, 1, 1);
+            return matches_byday(rule, day, (int)(day - start) / 7 + 1, (int)(end - 1 - day) / 7 + 1);
+        }
+        return bymonthday || ((bymonth || month == month0) && dayOfMonth == day0);
+    }
+}
+
+/**
+ * Function: is_simple
+ * -------------------
+ * @brief Checks whether the occurrences of a rule can be numbered directly.
+ *
+ * That is the case without BYDAY, BYMONTHDAY and BYMONTH, as long as every period holds
+ * the day of the first occurrence: not for a monthly rule starting after the
+ * 28th, nor for a yearly rule starting on February 29th.
+ *
+ * @param rule The rule.
+ * @param useBy Whether BYDAY, BYMONTHDAY or BYMONTH apply.
+ * @param firstDay The day number of the first occurrence.
+ * @return int 1 if the rule is simple, 0 otherwise.
+ *
+ */
+static int is_simple(const recurrence_t *rule, int useBy, long firstDay) {
+    int year, month, day;
+
+    civil_from_days(firstDay, &year, &month, &day);
+    if (useBy) {
+        return 0;
+    }
+    return rule->freq == FREQ_DAILY || rule->freq == FREQ_WEEKLY || (rule->freq == FREQ_MONTHLY && day <= 28) ||
+           (rule->freq == FREQ_YEARLY && !(month == 2 && day == 29));
+}
+
+/**
+ * Function: nth_day
+ * -----------------
+ * @brief Gets the day of occurrence n of a simple rule, in O(1).
+ *
+ * @param rule The rule.
+ * @param firstDay The day number of the first occurrence.
+ * @param n The occurrence, counting from 0.
+ * @return long The day number of the occurrence.
+ *
+ */
+static long nth_day(const recurrence_t *rule, long firstDay, long n) {
+    int year, month, day;
+
+    switch (rule->freq) {
+    case FREQ_DAILY:
+        return firstDay + n * rule->interval;
+    case FREQ_WEEKLY:
+        return firstDay + 7 * n * rule->interval;
+    case FREQ_MONTHLY: {
+        civil_from_days(firstDay, &year, &month, &day);
+        long index = year * 12L + month - 1 + n * rule->interval;
+        return days_from_civil((int)floor_div(index, 12), (int)(index - floor_div(index, 12) * 12) + 1, day);
+    }
+    default:
+        civil_from_days(firstDay, &year, &month, &day);
+        return days_from_civil((int)(year + n * rule->interval), month, day);
+    }
+}
+
+/**
+ * Function: rrule_matches
+ * -----------------------
+ * @brief Checks whether a date can start a series of a rule, i.e. its BYDAY, BYMONTHDAY and BYMONTH parts match it.
+ *
+ * @param rule The rule.
+ * @param date The date (YYYYMMDD).
+ * @return int 1 if the date matches, 0 otherwise.
+ *
+ */
+int rrule_matches(const recurrence_t *rule, long long date) {
+    long day = date_to_days(date);
+    int byday = 0;
+
+    for (int i = 0; i < 7; i++) {
+        byday = byday || rule->byday[i] != 0;
+    }
+    return day_matches(rule, byday, rule->bymonthday != 0, rule->bymonth != 0, day, day);
+}
+
+/**
+ * Function: occurrences_begin
+ * ---------------------------
+ * @brief Starts iterating over the occurrences of an event that fall in a date range.
+ *
+ * An occurrence falls in the range if it starts on or after `from` and ends on or
+ * before `to`. Every occurrence lasts as long as the first one, which is always
+ * part of the series.
+ *
+ * RFC 5545 leaves the occurrences undefined when the start of the event does not
+ * match its rule (e.g. a Thursday start with BYDAY=WE). Such a rule is anchored on
+ * the start of the event instead: its BYDAY, BYMONTHDAY and BYMONTH parts are ignored.
+ *
+ * @param iter The iterator to set up.
+ * @param event The first occurrence of the event.
+ * @param rule How the event repeats, or NULL if it does not.
+ * @param from The first date of the range (YYYYMMDD).
+ * @param to The last date of the range (YYYYMMDD).
+ * @return void
+ *
+ */
+void occurrences_begin(occurrence_iter_t *iter, const event_t *event, const recurrence_t *rule,
+                       long long from, long long to) {
+    iter->event = event;
+    iter->rule = rule;
+    if (rule == NULL) {
+        // A single occurrence: the timestamps are compared as they are.
+        iter->simple = 1;
+        iter->done = event->start / 1000000 < from || event->end / 1000000 > to;
+        return;
+    }
+    iter->first_day = date_to_days(event->start / 1000000);
+    iter->length = date_to_days(event->end / 1000000) - iter->first_day;
+    iter->from = date_to_days(from);
+    iter->last_start = date_to_days(to) - iter->length;
+    iter->use_byday = 0;
+    for (int i = 0; i < 7; i++) {
+        iter->use_byday = iter->use_byday || rule->byday[i] != 0;
+    }
+    iter->use_bymonthday = rule->bymonthday != 0;
+    iter->use_bymonth = rule->bymonth != 0;
+    if (!day_matches(rule, iter->use_byday, iter->use_bymonthday, iter->use_bymonth, iter->first_day,
+                     iter->first_day)) {
+        iter->use_byday = 0;
+        iter->use_bymonthday = 0;
+        iter->use_bymonth = 0;
+    }
+    iter->simple = is_simple(rule, iter->use_byday || iter->use_bymonthday || iter->use_bymonth, iter->first_day);
+    iter->n = 0;
+    iter->period = 0;
+    iter->day = 0;
+    iter->period_end = 0;
+    iter->done = 0;
+
+    if (iter->from <= iter->first_day) {
+        return;
+    }
+    if (iter->simple) {
+        // Jump straight to the first occurrence on or after `from`.
+        iter->n = period_of(rule, iter->first_day, iter->from);
+        while (nth_day(rule, iter->first_day, iter->n) < iter->from) {
+            iter->n++;
+        }
+    } else if (rule->count == 0) {
+        // Without COUNT the earlier periods do not matter.
+        iter->period = period_of(rule, iter->first_day, iter->from);
+    }
+}
+
+/**
+ * Function: period_length
+ * -----------------------
+ * @brief Gets the number of days in the period of a rule that starts on a day.
+ *
+ * @param rule The rule.
+ * @param start The day number the period starts on.
+ * @return long The number of days in the period.
+ *
+ */
+static long period_length(const recurrence_t *rule, long start) {
+    int year, month, day;
+
+    civil_from_days(start, &year, &month, &day);
+    switch (rule->freq) {
+    case FREQ_DAILY:
+        return 1;
+    case FREQ_WEEKLY:
+        return 7;
+    case FREQ_MONTHLY:
+        return days_in_month(year, month);
+    default:
+        return days_from_civil(year + 1, 1, 1) - start;
+    }
+}
+
+/**
+ * Function: next_day
+ * ------------------
+ * @brief Finds the next occurrence day of a rule that is not simple.
+ *
+ * The days of the current period are checked one by one from the cursor of the
+ * iterator, moving on to the next period once it is exhausted. A rule without
+ * BYDAY and BYMONTHDAY (nor, for a yearly rule, BYMONTH) has at most one
+ * occurrence per period, so the cursor starts on the day it would be and the
+ * rest of the period is skipped.
+ *
+ * @param iter The iterator.
+ * @return long The day number of the next occurrence, or a day past `last_start` if there is none.
+ *
+ */
+static long next_day(occurrence_iter_t *iter) {
+    const recurrence_t *rule = iter->rule;
+    int oneDay = !iter->use_byday && !iter->use_bymonthday && !(rule->freq == FREQ_YEARLY && iter->use_bymonth);
+
+    for (;;) {
+        for (; iter->day < iter->period_end; iter->day++) {
+            if (iter->day >= iter->first_day &&
+                day_matches(rule, iter->use_byday, iter->use_bymonthday, iter->use_bymonth, iter->first_day,
+                            iter->day)) {
+                return iter->day++;
+            }
+            if (oneDay) {
+                iter->day = iter->period_end;
+            }
+        }
+
+        long start = period_start(rule, iter->first_day, iter->period++);
+        if (start > iter->last_start) {
+            return start;
+        }
+        iter->day = start;
+        iter->period_end = start + period_length(rule, start);
+        if (oneDay) {
+            int year0, month0, day0, year, month, day;
+            civil_from_days(iter->first_day, &year0, &month0, &day0);
+            civil_from_days(start, &year, &month, &day);
+            iter->day = rule->freq == FREQ_WEEKLY    ? start + (weekday(iter->first_day) - rule->wkst + 7) % 7
+                        : rule->freq == FREQ_MONTHLY ? start + day0 - 1
+                                                     : days_from_civil(year, month0, day0);
+        }
+    }
+}
+
+/**
+ * Function: occurrences_next
+ * --------------------------
+ * @brief Gets the next occurrence of the event in the range.
+ *
+ * @param iter The iterator.
+ * @param occurrence Set to the next occurrence; it shares the strings of the event.
+ * @return int 1 if there was another occurrence, 0 at the end of the range.
+ *
+ */
+int occurrences_next(occurrence_iter_t *iter, event_t *occurrence) {
+    const recurrence_t *rule = iter->rule;
+    const event_t *event = iter->event;
+
+    if (rule == NULL) {
+        if (iter->done) {
+            return 0;
+        }
+        *occurrence = *event;
+        iter->done = 1;
+        return 1;
+    }
+    while (!iter->done) {
+        long day = iter->simple ? nth_day(rule, iter->first_day, iter->n) : next_day(iter);
+
+        iter->n++;
+        long long start = days_to_date(day) * 1000000 + event->start % 1000000;
+        if ((rule->count != 0 && iter->n > rule->count) || day > iter->last_start ||
+            (rule->until != 0 && start > rule->until)) {
+            break;
+        }
+        if (day < iter->from) {
+            continue;
+        }
+
+        *occurrence = *event;
+        occurrence->start = start;
+        occurrence->end = days_to_date(day + iter->length) * 1000000 + event->end % 1000000;
+        return 1;
+    }
+
+    iter->done = 1;
+    return 0;
+}
+
+/**
+ * Function: rrule_nth
+ * -------------------
+ * @brief Gets occurrence n of an event, counting from 0.
+ *
+ * This takes O(1) for a rule without BYDAY, BYMONTHDAY and BYMONTH (see is_simple());
+ * other rules are walked from the start.
+ *
+ * @param event The first occurrence of the event.
+ * @param rule How the event repeats, or NULL if it does not.
+ * @param n The occurrence to get.
+ * @param occurrence Set to the occurrence.
+ * @return int 1 if the event has an occurrence n, 0 if COUNT or UNTIL ends it before.
+ *
+ */
+int rrule_nth(const event_t *event, const recurrence_t *rule, long n, event_t *occurrence) {
+    occurrence_iter_t iter;
+
+    occurrences_begin(&iter, event, rule, event->start / 1000000, 99991231);
+    if (rule == NULL) {
+        *occurrence = *event;
+        return n == 0;
+    }
+    if (iter.simple) {
+        iter.n = n;
+        return occurrences_next(&iter, occurrence);
+    }
+    for (long i = 0; i <= n; i++) {
+        if (!occurrences_next(&iter, occurrence)) {
+            return 0;
+        }
+    }
+    return 1;
+}
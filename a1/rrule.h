@@ -0,0 +1,45 @@
+/** @file rrule.h
+ *  @brief Function prototypes for the recurrence rule engine.
+ *
+ */
+#ifndef _RRULE_H_
+#define _RRULE_H_
+
+#include "event_table.h"
+
+/**
+ * @brief An iterator over the occurrences of an event that fall in a date range.
+ *
+ * A rule without BYDAY or BYMONTHDAY has occurrences that can be numbered
+ * directly (see rrule_nth()), so the iterator jumps to the first one in the
+ * range. Other rules are walked period by period (a day, week, month or year
+ * times INTERVAL), starting from the period that holds the range unless COUNT
+ * requires the earlier occurrences to be counted; `day` is the next day of the
+ * current period to check and `period_end` the first day after it.
+ */
+typedef struct occurrence_iter {
+    const event_t *event;
+    const recurrence_t *rule;
+    long first_day;
+    long length;
+    long from;
+    long last_start;
+    int simple;
+    int use_byday;
+    int use_bymonthday;
+    int use_bymonth;
+    long n;
+    long period;
+    long day;
+    long period_end;
+    int done;
+} occurrence_iter_t;
+
+int parse_rrule(const char *line, recurrence_t *rule);
+int rrule_matches(const recurrence_t *rule, long long date);
+int rrule_nth(const event_t *event, const recurrence_t *rule, long n, event_t *occurrence);
+void occurrences_begin(occurrence_iter_t *iter, const event_t *event, const recurrence_t *rule,
+                       long long from, long long to);
+int occurrences_next(occurrence_iter_t *iter, event_t *occurrence);
+
+#endif
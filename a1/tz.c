@@ -0,0 +1,686 @@
+/** @file tz.c
+ *  @brief Implementation of tz.h
+ *
+ * A zone comes either from a VTIMEZONE of the calendar (see ics_parse.c, which
+ * adds its transitions with tz_add()), or from a zoneinfo file (RFC 8536, "TZif"),
+ * or from a POSIX TZ string such as "EST5EDT,M3.2.0,M11.1.0". Either way it is
+ * compiled once into a sorted array of transitions, and every conversion after
+ * that is a binary search plus some day arithmetic (see date.h): no mktime(),
+ * localtime() or TZ environment variable is involved.
+ *
+ */
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include "date.h"
+#include "emalloc.h"
+#include "tz.h"
+
+/**
+ * Function: tz_init
+ * -----------------
+ * @brief Starts a zone without transitions.
+ *
+ * @param tz The zone.
+ * @param offset The UTC offset of the zone before its first transition, in seconds.
+ * @return void
+ *
+ */
+void tz_init(tz_t *tz, int offset) {
+    tz->transitions = NULL;
+    tz->count = 0;
+    tz->capacity = 0;
+    tz->offset = offset;
+}
+
+/**
+ * Function: tz_add
+ * ----------------
+ * @brief Adds a transition to a zone, in any order; tz_finish() sorts them.
+ *
+ * @param tz The zone.
+ * @param at When the offset changes, in seconds since 1970-01-01 00:00:00 UTC.
+ * @param offset The UTC offset from then on, in seconds.
+ * @return void
+ *
+ */
+void tz_add(tz_t *tz, long long at, int offset) {
+    if (tz->count == tz->capacity) {
+        int capacity = tz->capacity > 0 ? 2 * tz->capacity : 16;
+        tz_transition_t *transitions = (tz_transition_t *)emalloc(capacity * sizeof(tz_transition_t));
+        if (tz->count > 0) {
+            memcpy(transitions, tz->transitions, tz->count * sizeof(tz_transition_t));
+        }
+        free(tz->transitions);
+        tz->transitions = transitions;
+        tz->capacity = capacity;
+    }
+    tz->transitions[tz->count].at = at;
+    tz->transitions[tz->count].local = 0;
+    tz->transitions[tz->count++].offset = offset;
+}
+
+/**
+ * Function: compare_at
+ * --------------------
+ * @brief Orders transitions by time (for qsort()).
+ *
+ * @param a The first transition.
+ * @param b The second transition.
+ * @return int A negative, zero or positive number as a comes before, with or after b.
+ *
+ */
+static int compare_at(const void *a, const void *b) {
+    long long at1 = ((const tz_transition_t *)a)->at;
+    long long at2 = ((const tz_transition_t *)b)->at;
+
+    return at1 < at2 ? -1 : at1 > at2;
+}
+
+/**
+ * Function: tz_finish
+ * -------------------
+ * @brief Sorts the transitions of a zone and works out the local time each one takes effect at.
+ *
+ * Transitions that do not change the offset are dropped, as are all but one of
+ * the transitions at the same time.
+ *
+ * @param tz The zone.
+ * @return void
+ *
+ */
+void tz_finish(tz_t *tz) {
+    int count = 0; int before = tz->offset;
+
+    if (tz->count > 1) {
+        qsort(tz->transitions, tz->count, sizeof(tz_transition_t), compare_at);
+    }
+    for (int i = 0; i < tz->count; i++) {
+        tz_transition_t transition = tz->transitions[i];
+        if (count > 0 && tz->transitions[count - 1].at == transition.at) {
+            count--;
+            before = count > 0 ? tz->transitions[count - 1].offset : tz->offset;
+        }
+        if (transition.offset == before) {
+            continue;
+        }
+        transition.local = transition.at + (transition.offset > before ? transition.offset : before);
+        tz->transitions[count++] = transition;
+        before = transition.offset;
+    }
+    tz->count = count;
+}
+
+/**
+ * Function: tz_parse_offset
+ * -------------------------
+ * @brief Parses a UTC offset of iCalendar, e.g. the value of TZOFFSETFROM.
+ *
+ * For example: "-0500" gives -18000 and "+053000" gives 19800.
+ *
+ * @param text The offset, "+HHMM" or "-HHMM", with optional seconds.
+ * @param offset Set to the offset, in seconds.
+ * @return int 1 if the offset is well formed, 0 otherwise.
+ *
+ */
+int tz_parse_offset(const char *text, int *offset) {
+    int digits[6]; int n = 0;
+
+    if (*text != '+' && *text != '-') {
+        return 0;
+    }
+    for (const char *p = text + 1; *p >= '0' && *p <= '9' && n < 6; p++) {
+        digits[n++] = *p - '0';
+    }
+    if (n != 4 && n != 6) {
+        return 0;
+    }
+    int seconds = (digits[0] * 10 + digits[1]) * 3600 + (digits[2] * 10 + digits[3]) * 60 +
+                  (n == 6 ? digits[4] * 10 + digits[5] : 0);
+    *offset = *text == '-' ? -seconds : seconds;
+    return 1;
+}
+
+/**
+ * Function: parse_hms
+ * -------------------
+ * @brief Parses a time of a POSIX TZ string, "[+|-]hh[:mm[:ss]]".
+ *
+ * @param text The text to read; it is advanced past the time.
+ * @param seconds Set to the time, in seconds.
+ * @return int 1 if there was a time, 0 otherwise.
+ *
+ */
+static int parse_hms(const char **text, long long *seconds) {
+    const char *p = *text;
+    int sign = *p == '-' ? -1 : 1;
+    long long value = 0;
+
+    if (*p == '+' || *p == '-') {
+        p++;
+    }
+    if (*p < '0' || *p > '9') {
+        return 0;
+    }
+    for (int part = 0; part < 3; part++) {
+        long long field = 0;
+        while (*p >= '0' && *p <= '9') {
+            field = field * 10 + (*p++ - '0');
+        }
+        value += field * (part == 0 ? 3600 : part == 1 ? 60 : 1);
+        if (part == 2 || *p != ':' || p[1] < '0' || p[1] > '9') {
+            break;
+        }
+        p++;
+    }
+    *seconds = sign * value;
+    *text = p;
+    return 1;
+}
+
+/**
+ * Function: skip_name
+ * -------------------
+ * @brief Skips the name of a zone in a POSIX TZ string, e.g. "EST" or "<+0530>".
+ *
+ * @param text The text to read; it is advanced past the name.
+ * @return int 1 if there was a name, 0 otherwise.
+ *
+ */
+static int skip_name(const char **text) {
+    const char *p = *text;
+
+    if (*p == '<') {
+        p = strchr(p, '>');
+        if (p == NULL) {
+            return 0;
+        }
+        *text = p + 1;
+        return 1;
+    }
+    while ((*p >= 'A' && *p <= 'Z') || (*p >= 'a' && *p <= 'z')) {
+        p++;
+    }
+    if (p - *text < 3) {
+        return 0;
+    }
+    *text = p;
+    return 1;
+}
+
+/**
+ * @brief When a rule of a POSIX TZ string applies in a year: the day (a month, a week
+ *        from 1 to 5, 5 being the last one, and a weekday from 0 for Sunday, as in
+ *        "M3.2.0"; or the day of the year, from 1 and without February 29 for "Jn",
+ *        from 0 for "n") and the local time of day, in seconds.
+ */
+typedef struct tz_rule {
+    char kind;
+    int month;
+    int week;
+    int weekday;
+    int day;
+    long long time;
+} tz_rule_t;
+
+/**
+ * Function: parse_rule
+ * --------------------
+ * @brief Parses the start or the end of daylight time in a POSIX TZ string, e.g. "M3.2.0/2".
+ *
+ * @param text The text to read, just after the ','; it is advanced past the rule.
+ * @param rule Set to the rule.
+ * @return int 1 if the rule is well formed, 0 otherwise.
+ *
+ */
+static int parse_rule(const char **text, tz_rule_t *rule) {
+    const char *p = *text;
+    char *end;
+
+    rule->time = 7200;
+    if (*p == 'M') {
+        rule->kind = 'M';
+        rule->month = (int)strtol(p + 1, &end, 10);
+        if (*end != '.') {
+            return 0;
+        }
+        rule->week = (int)strtol(end + 1, &end, 10);
+        if (*end != '.') {
+            return 0;
+        }
+        rule->weekday = (int)strtol(end + 1, &end, 10);
+        if (rule->month < 1 || rule->month > 12 || rule->week < 1 || rule->week > 5 || rule->weekday < 0 ||
+            rule->weekday > 6) {
+            return 0;
+        }
+    } else {
+        rule->kind = *p == 'J' ? 'J' : 'n';
+        if (*p == 'J') {
+            p++;
+        }
+        if (*p < '0' || *p > '9') {
+            return 0;
+        }
+        rule->day = (int)strtol(p, &end, 10);
+        if (rule->day > 365 || (rule->kind == 'J' && rule->day < 1)) {
+            return 0;
+        }
+    }
+    p = end;
+    if (*p == '/' && !(p++, parse_hms(&p, &rule->time))) {
+        return 0;
+    }
+    *text = p;
+    return 1;
+}
+
+/**
+ * Function: rule_day
+ * ------------------
+ * @brief Gets the day a rule of a POSIX TZ string applies on in a year.
+ *
+ * @param rule The rule.
+ * @param year The year.
+ * @return long The day number (see days_from_civil()).
+ *
+ */
+static long rule_day(const tz_rule_t *rule, int year) {
+    long first = days_from_civil(year, 1, 1);
+
+    if (rule->kind == 'J') {
+        int leap = days_from_civil(year, 3, 1) - days_from_civil(year, 2, 28) == 2;
+        return first + rule->day - 1 + (leap && rule->day >= 60);
+    }
+    if (rule->kind == 'n') {
+        return first + rule->day;
+    }
+    long month = days_from_civil(year, rule->month, 1);
+    long next = days_from_civil(rule->month == 12 ? year + 1 : year, rule->month == 12 ? 1 : rule->month + 1, 1);
+    long weekday = ((month + 4) % 7 + 7) % 7;
+    long day = month + (rule->weekday - weekday + 7) % 7 + 7 * (rule->week - 1);
+    while (day >= next) {
+        day -= 7;
+    }
+    return day;
+}
+
+/**
+ * Function: parse_posix
+ * ---------------------
+ * @brief Compiles a POSIX TZ string, e.g. "CET-1CEST,M3.5.0,M10.5.0/3", into a zone.
+ *
+ * The daylight time rules are turned into the transitions of every year up to
+ * TZ_LAST_YEAR, but only the ones after `after`: a zoneinfo file gives its
+ * transitions up to some year, and its TZ string the ones that follow.
+ *
+ * @param spec The TZ string.
+ * @param tz The zone; its offset is set if it has no transitions yet.
+ * @param after The time the transitions start after (LLONG_MIN for all of them).
+ * @return int 1 if the TZ string is well formed, 0 otherwise.
+ *
+ */
+static int parse_posix(const char *spec, tz_t *tz, long long after) {
+    const char *p = spec;
+    long long std; long long dst;
+    tz_rule_t start; tz_rule_t end;
+
+    if (!skip_name(&p) || !parse_hms(&p, &std)) {
+        return 0;
+    }
+    std = -std;
+    if (*p == '\0') {
+        if (tz->count == 0) {
+            tz->offset = (int)std;
+        }
+        return 1;
+    }
+    if (!skip_name(&p)) {
+        return 0;
+    }
+    dst = std + 3600;
+    if (*p != ',' && *p != '\0') {
+        if (!parse_hms(&p, &dst)) {
+            return 0;
+        }
+        dst = -dst;
+    }
+    if (*p != ',' || !(p++, parse_rule(&p, &start)) || *p != ',' || !(p++, parse_rule(&p, &end)) || *p != '\0') {
+        return 0;
+    }
+
+    int year = 1970;
+    if (after != LLONG_MIN) {
+        year = (int)(seconds_to_timestamp(after) / 10000000000LL);
+    }
+    if (tz->count == 0) {
+        tz->offset = (int)std;
+    }
+    for (; year <= TZ_LAST_YEAR; year++) {
+        long long begins = rule_day(&start, year) * 86400LL + start.time - std;
+        long long ends = rule_day(&end, year) * 86400LL + end.time - dst;
+        if (begins > after) {
+            tz_add(tz, begins, (int)dst);
+        }
+        if (ends > after) {
+            tz_add(tz, ends, (int)std);
+        }
+    }
+    return 1;
+}
+
+/**
+ * Function: be32
+ * --------------
+ * @brief Reads a big-endian 32-bit integer of a zoneinfo file.
+ *
+ * @param p The bytes.
+ * @return long long The integer, signed.
+ *
+ */
+static long long be32(const unsigned char *p) {
+    unsigned long value = (unsigned long)p[0] << 24 | (unsigned long)p[1] << 16 | (unsigned long)p[2] << 8 | p[3];
+
+    return value >= 0x80000000UL ? (long long)value - 0x100000000LL : (long long)value;
+}
+
+/**
+ * Function: be64
+ * --------------
+ * @brief Reads a big-endian 64-bit integer of a zoneinfo file.
+ *
+ * @param p The bytes.
+ * @return long long The integer, signed.
+ *
+ */
+static long long be64(const unsigned char *p) {
+    unsigned long long value = 0;
+
+    for (int i = 0; i < 8; i++) {
+        value = value << 8 | p[i];
+    }
+    return (long long)value;
+}
+
+/**
+ * Function: block_size
+ * --------------------
+ * @brief Gets the size of the data block that follows a header of a zoneinfo file.
+ *
+ * @param header The header (44 bytes).
+ * @param timeSize The size of a time in the block: 4 for version 1, 8 after.
+ * @return size_t The size of the block.
+ *
+ */
+static size_t block_size(const unsigned char *header, size_t timeSize) {
+    size_t isut = (size_t)be32(header + 20) & 0xffffffffUL; size_t isstd = (size_t)be32(header + 24) & 0xffffffffUL;
+    size_t leap = (size_t)be32(header + 28) & 0xffffffffUL; size_t timecnt = (size_t)be32(header + 32) & 0xffffffffUL;
+    size_t typecnt = (size_t)be32(header + 36) & 0xffffffffUL; size_t charcnt = (size_t)be32(header + 40) & 0xffffffffUL;
+
+    return timecnt * (timeSize + 1) + typecnt * 6 + charcnt + leap * (timeSize + 4) + isstd + isut;
+}
+
+/**
+ * Function: load_tzif
+ * -------------------
+ * @brief Compiles the contents of a zoneinfo file into a zone.
+ *
+ * The 64-bit data of a version 2 (or later) file is used when there is one, with
+ * the TZ string at its end for the transitions after the last one listed.
+ *
+ * @param data The contents of the file.
+ * @param len Their length.
+ * @param tz The zone, without transitions yet.
+ * @return int 1 if the file is a well-formed zoneinfo file, 0 otherwise.
+ *
+ */
+static int load_tzif(const unsigned char *data, size_t len, tz_t *tz) {
+    const unsigned char *header = data;
+    size_t timeSize = 4;
+
+    if (len < 44 || memcmp(data, "TZif", 4) != 0) {
+        return 0;
+    }
+    if (data[4] >= '2') {
+        size_t skip = 44 + block_size(data, 4);
+        if (skip > len || len - skip < 44 || memcmp(data + skip, "TZif", 4) != 0) {
+            return 0;
+        }
+        header = data + skip;
+        timeSize = 8;
+    }
+
+    size_t timecnt = (size_t)be32(header + 32) & 0xffffffffUL;
+    size_t typecnt = (size_t)be32(header + 36) & 0xffffffffUL;
+    size_t block = block_size(header, timeSize);
+    const unsigned char *times = header + 44;
+    if (typecnt == 0 || timecnt > len || typecnt > len || block > len - (size_t)(times - data)) {
+        return 0;
+    }
+    const unsigned char *types = times + timecnt * timeSize;
+    const unsigned char *infos = types + timecnt;
+    tz->offset = (int)be32(infos);
+    for (size_t i = 0; i < timecnt; i++) {
+        if (types[i] >= typecnt) {
+            return 0;
+        }
+        long long at = timeSize == 8 ? be64(times + 8 * i) : be32(times + 4 * i);
+        tz_add(tz, at, (int)be32(infos + 6 * types[i]));
+    }
+
+    const char *footer = (const char *)times + block;
+    const char *stop = (const char *)data + len;
+    if (timeSize == 8 && footer < stop && *footer == '\n') {
+        const char *newline = memchr(footer + 1, '\n', stop - footer - 1);
+        if (newline != NULL && newline - footer < 128) {
+            char spec[128];
+            memcpy(spec, footer + 1, newline - footer - 1);
+            spec[newline - footer - 1] = '\0';
+            long long last = LLONG_MIN;
+            for (int i = 0; i < tz->count; i++) {
+                last = tz->transitions[i].at > last ? tz->transitions[i].at : last;
+            }
+            parse_posix(spec, tz, last);
+        }
+    }
+    return 1;
+}
+
+/**
+ * Function: read_file
+ * -------------------
+ * @brief Reads a whole (small) file into memory.
+ *
+ * @param path The path of the file.
+ * @param len Set to the length of the file.
+ * @return unsigned char* The contents of the file, to be freed by the caller, or NULL if it cannot be read.
+ *
+ */
+static unsigned char *read_file(const char *path, size_t *len) {
+    FILE *file = fopen(path, "rb");
+    size_t capacity = 4096;
+
+    if (file == NULL) {
+        return NULL;
+    }
+    unsigned char *data = (unsigned char *)emalloc(capacity);
+    *len = 0;
+    for (;;) {
+        *len += fread(data + *len, 1, capacity - *len, file);
+        if (*len < capacity || capacity >= (1 << 22)) {
+            break;
+        }
+        unsigned char *bigger = (unsigned char *)emalloc(2 * capacity);
+        memcpy(bigger, data, *len);
+        free(data);
+        data = bigger;
+        capacity *= 2;
+    }
+    fclose(file);
+    return data;
+}
+
+/**
+ * Function: zone_path
+ * -------------------
+ * @brief Gets the path of the zoneinfo file of a zone (see tz_load()).
+ *
+ * @param name The name of the zone, without a leading ':'.
+ * @return char* The path, to be freed, or NULL if the name cannot be a zoneinfo file.
+ *
+ */
+static char *zone_path(const char *name) {
+    const char *dir = getenv("TZDIR") != NULL && getenv("TZDIR")[0] != '\0' ? getenv("TZDIR") : TZ_DIR;
+
+    if (*name == '\0' || strstr(name, "..") != NULL) {
+        return NULL;
+    }
+    char *path = (char *)emalloc(strlen(dir) + strlen(name) + 2);
+    if (name[0] == '/') {
+        strcpy(path, name);
+    } else {
+        sprintf(path, "%s/%s", dir, name);
+    }
+    return path;
+}
+
+/**
+ * Function: tz_load
+ * -----------------
+ * @brief Compiles a zone known to the system, by name.
+ *
+ * The name is looked up as a zoneinfo file (a name such as "America/Vancouver"
+ * under TZDIR, or TZ_DIR when TZDIR is not set, or an absolute path such as
+ * "/etc/localtime"), then read as a POSIX TZ string. As in the TZ environment
+ * variable, a leading ':' is ignored. "UTC" and "GMT" are known even without a
+ * zoneinfo directory.
+ *
+ * @param name The name of the zone.
+ * @param tz Set to the zone, to be freed with tz_free().
+ * @return int 1 if the zone was found, 0 otherwise (then `tz` is UTC).
+ *
+ */
+int tz_load(const char *name, tz_t *tz) {
+    if (*name == ':') {
+        name++;
+    }
+    tz_init(tz, 0);
+    if (*name == '\0') {
+        return 0;
+    }
+    char *path = zone_path(name);
+    if (path != NULL) {
+        size_t len;
+        unsigned char *data = read_file(path, &len);
+        free(path);
+        if (data != NULL) {
+            int ok = load_tzif(data, len, tz);
+            free(data);
+            if (ok) {
+                tz_finish(tz);
+                return 1;
+            }
+            tz_free(tz);
+            tz_init(tz, 0);
+        }
+    }
+    if (parse_posix(name, tz, LLONG_MIN)) {
+        tz_finish(tz);
+        return 1;
+    }
+    tz_free(tz);
+    tz_init(tz, 0);
+    return strcmp(name, "UTC") == 0 || strcmp(name, "GMT") == 0;
+}
+
+/**
+ * Function: tz_stamp
+ * ------------------
+ * @brief Gets the modification time of the zoneinfo file tz_load() would read for a zone.
+ *
+ * A zone compiled from the system is only good as long as this stays the same:
+ * the zoneinfo files are replaced when the time zone database is updated.
+ *
+ * @param name The name of the zone.
+ * @return long long The modification time in nanoseconds, or -1 if there is no such file.
+ *
+ */
+long long tz_stamp(const char *name) {
+    char *path = zone_path(*name == ':' ? name + 1 : name);
+    struct stat st;
+    long long stamp = -1;
+
+    if (path != NULL && stat(path, &st) == 0) {
+        stamp = st.st_mtim.tv_sec * 1000000000LL + st.st_mtim.tv_nsec;
+    }
+    free(path);
+    return stamp;
+}
+
+/**
+ * Function: tz_to_utc
+ * -------------------
+ * @brief Converts a local time of a zone into UTC.
+ *
+ * @param tz The zone.
+ * @param local The local time (YYYYMMDDhhmmss).
+ * @return long long The same instant in UTC (YYYYMMDDhhmmss).
+ *
+ */
+long long tz_to_utc(const tz_t *tz, long long local) {
+    long long seconds = timestamp_to_seconds(local);
+    int low = 0; int high = tz->count;
+
+    // Find the first transition that takes effect after the local time.
+    while (low < high) {
+        int middle = low + (high - low) / 2;
+        if (tz->transitions[middle].local <= seconds) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    return seconds_to_timestamp(seconds - (low > 0 ? tz->transitions[low - 1].offset : tz->offset));
+}
+
+/**
+ * Function: tz_from_utc
+ * ---------------------
+ * @brief Converts a time in UTC into the local time of a zone.
+ *
+ * @param tz The zone.
+ * @param utc The time in UTC (YYYYMMDDhhmmss).
+ * @return long long The local time (YYYYMMDDhhmmss).
+ *
+ */
+long long tz_from_utc(const tz_t *tz, long long utc) {
+    long long seconds = timestamp_to_seconds(utc);
+    int low = 0; int high = tz->count;
+
+    while (low < high) {
+        int middle = low + (high - low) / 2;
+        if (tz->transitions[middle].at <= seconds) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    return seconds_to_timestamp(seconds + (low > 0 ? tz->transitions[low - 1].offset : tz->offset));
+}
+
+/**
+ * Function: tz_free
+ * -----------------
+ * @brief Frees the transitions of a zone (but not the zone itself).
+ *
+ * @param tz The zone.
+ * @return void
+ *
+ */
+void tz_free(tz_t *tz) {
+    free(tz->transitions);
+    tz->transitions = NULL;
+    tz->count = 0;
+    tz->capacity = 0;
+}
@@ -0,0 +1,59 @@
+/** @file tz.h
+ *  @brief Function prototypes for time zones compiled into tables of UTC offset transitions.
+ *
+ */
+#ifndef _TZ_H_
+#define _TZ_H_
+
+/**
+ * @brief The directory the zones named by --tz, TZ and TZID are looked up in, unless TZDIR says otherwise.
+ */
+#define TZ_DIR "/usr/share/zoneinfo"
+
+/**
+ * @brief The last year the transitions of a rule (a VTIMEZONE RRULE, or the TZ string at the
+ *        end of a zoneinfo file) are generated for; later times keep the last offset.
+ */
+#define TZ_LAST_YEAR 2100
+
+/**
+ * @brief A change of the UTC offset of a zone.
+ *
+ * From `at` (seconds since 1970-01-01 00:00:00 UTC) on, the clock of the zone reads
+ * UTC plus `offset` seconds. `local` is the clock reading (in seconds, see
+ * timestamp_to_seconds()) from which a local time is read with the new offset: the
+ * later of the two readings at the change. So a time skipped by a change forward is
+ * read with the offset before it, and a time repeated by a change back is read as
+ * the first of the two (RFC 5545, section 3.3.5).
+ */
+typedef struct tz_transition {
+    long long at;
+    long long local;
+    int offset;
+} tz_transition_t;
+
+/**
+ * @brief A compiled zone: its transitions, sorted, and the offset before the first one.
+ *
+ * Converting a time takes a binary search of the transitions, whatever the zone
+ * and however many there are. A zone kept in an event table is a view into the
+ * transitions of the table (see table_get_zone()), and is not freed.
+ */
+typedef struct tz {
+    tz_transition_t *transitions;
+    int count;
+    int capacity;
+    int offset;
+} tz_t;
+
+void tz_init(tz_t *tz, int offset);
+void tz_add(tz_t *tz, long long at, int offset);
+void tz_finish(tz_t *tz);
+int tz_load(const char *name, tz_t *tz);
+long long tz_stamp(const char *name);
+int tz_parse_offset(const char *text, int *offset);
+long long tz_to_utc(const tz_t *tz, long long local);
+long long tz_from_utc(const tz_t *tz, long long utc);
+void tz_free(tz_t *tz);
+
+#endif
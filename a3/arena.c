@@ -0,0 +1,131 @@
+/** @file arena.c
+ *  @brief Implementation of arena.h
+ *
+ */
+#include <stdlib.h>
+#include <string.h>
+#include "emalloc.h"
+#include "arena.h"
+
+/**
+ * @brief The alignment of every allocation, enough for any scalar type.
+ */
+#define ARENA_ALIGN 16
+
+/**
+ * @brief The space taken by the header at the start of each block.
+ */
+#define BLOCK_HEADER ((sizeof(arena_block_t) + ARENA_ALIGN - 1) & ~(size_t)(ARENA_ALIGN - 1))
+
+/**
+ * @brief Allocate a new block with room for `size` bytes after its header.
+ */
+static arena_block_t *new_block(size_t size)
+{
+    arena_block_t *block = (arena_block_t *)emalloc(BLOCK_HEADER + size);
+
+    block->next = NULL;
+    block->size = size;
+    block->used = 0;
+    return block;
+}
+
+/**
+ * Function:  arena_create
+ * -----------------------
+ * @brief  Allows to create an empty arena.
+ *
+ * @param block_size The size of the blocks the arena allocates from. Larger
+ *                   allocations get a block of their own.
+ *
+ * @return arena_t* A pointer to the new arena.
+ *
+ */
+arena_t *arena_create(size_t block_size)
+{
+    arena_t *arena = (arena_t *)emalloc(sizeof(arena_t));
+
+    arena->block_size = block_size < ARENA_ALIGN ? ARENA_ALIGN : block_size;
+    arena->blocks = new_block(arena->block_size);
+    return arena;
+}
+
+/**
+ * Function:  arena_alloc
+ * ----------------------
+ * @brief  Allows to reserve memory from an arena.
+ *
+ * The memory lives until the arena is destroyed. Like emalloc(), the program
+ * exits if no memory is left.
+ *
+ * @param arena The arena.
+ * @param n The number of bytes to reserve.
+ *
+ * @return void* A pointer to the memory, aligned for any scalar type.
+ *
+ */
+void *arena_alloc(arena_t *arena, size_t n)
+{
+    arena_block_t *block = arena->blocks;
+    size_t size = (n + ARENA_ALIGN - 1) & ~(size_t)(ARENA_ALIGN - 1);
+
+    if (size > arena->block_size / 4)
+    {
+        /* a large allocation gets a block of its own, behind the current one */
+        arena_block_t *large = new_block(size);
+        large->used = size;
+        large->next = block->next;
+        block->next = large;
+        return (char *)large + BLOCK_HEADER;
+    }
+
+    if (block->size - block->used < size)
+    {
+        block = new_block(arena->block_size);
+        block->next = arena->blocks;
+        arena->blocks = block;
+    }
+    block->used += size;
+    return (char *)block + BLOCK_HEADER + block->used - size;
+}
+
+/**
+ * Function:  arena_strdup
+ * -----------------------
+ * @brief  Allows to copy a string into an arena.
+ *
+ * @param arena The arena.
+ * @param s The string to copy.
+ *
+ * @return char* The copy, which lives until the arena is destroyed.
+ *
+ */
+char *arena_strdup(arena_t *arena, const char *s)
+{
+    size_t len = strlen(s) + 1;
+    char *copy = (char *)arena_alloc(arena, len);
+
+    memcpy(copy, s, len);
+    return copy;
+}
+
+/**
+ * Function:  arena_destroy
+ * ------------------------
+ * @brief  Allows to release an arena and everything allocated from it.
+ *
+ * @param arena The arena to destroy.
+ *
+ */
+void arena_destroy(arena_t *arena)
+{
+    arena_block_t *block = arena->blocks;
+
+    while (block != NULL)
+    {
+        arena_block_t *next = block->next;
+        free(block);
+        block = next;
+    }
+    free(arena);
+}
@@ -0,0 +1,33 @@
+/** @file arena.h
+ *  @brief Function prototypes for the arena allocator.
+ *
+ */
+#ifndef _ARENA_H_
+#define _ARENA_H_
+
+#include <stddef.h>
+
+/**
+ * @brief A block of memory the arena hands out allocations from.
+ */
+typedef struct arena_block {
+    struct arena_block *next;
+    size_t size;
+    size_t used;
+} arena_block_t;
+
+/**
+ * @brief A bump allocator: memory is carved out of large blocks and never freed
+ *        one allocation at a time; arena_destroy() releases all of it at once.
+ */
+typedef struct arena {
+    arena_block_t *blocks;
+    size_t block_size;
+} arena_t;
+
+arena_t *arena_create(size_t block_size);
+void *arena_alloc(arena_t *arena, size_t n);
+char *arena_strdup(arena_t *arena, const char *s);
+void arena_destroy(arena_t *arena);
+
+#endif
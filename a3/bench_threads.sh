@@ -0,0 +1,27 @@
+#!/bin/bash
+# Measures how music_manager scales with --threads on a large input.
+# Usage: ./bench_threads.sh [FILE] [MAX_THREADS]
+
+FILE=${1:-bench_songs.csv}
+MAX_THREADS=${2:-$(nproc)}
+TIMEFORMAT=%R
+
+# Prints the best wall-clock time (in seconds) of three runs of music_manager.
+run() {
+    for i in 1 2 3; do
+        { time ./music_manager "$@" > /dev/null; } 2>&1
+    done | sort -n | head -n 1
+}
+
+echo "input: $FILE ($(wc -l < "$FILE") lines)"
+for mode in heap full radix; do
+    base=
+    threads=1
+    while [ "$threads" -le "$MAX_THREADS" ]; do
+        t=$(run --sortBy=energy --display=10 --files="$FILE" --sortMode=$mode --threads=$threads)
+        [ -z "$base" ] && base=$t
+        awk -v mode=$mode -v n=$threads -v t=$t -v base=$base \
+            'BEGIN { printf "%-5s threads=%-3d %6.3f s  speedup %5.2fx\n", mode, n, t, base / t }'
+        threads=$((threads * 2))
+    done
+done
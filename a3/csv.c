@@ -0,0 +1,411 @@
+/** @file csv.c
+ *  @brief Implementation of a memory-mapped CSV reader.
+ *
+ * The whole input is mapped read-only with mmap() and tokenized row by row in
+ * place, using the separator offsets found by csv_scan(). When the input cannot be mapped (e.g., it is a pipe or an empty file)
+ * it is read into a single heap buffer instead, so callers see the same view.
+ *
+ */
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "emalloc.h"
+#include "csv.h"
+
+/**
+ * @brief The number of bytes scanned for separators at a time.
+ */
+#define SCAN_WINDOW (1 << 16)
+
+/**
+ * @brief Read the whole of a file descriptor into a heap buffer.
+ *
+ * @param fd The file descriptor to read from.
+ * @param csv The reader whose data and size are filled in.
+ */
+static void read_all(int fd, csv_file_t *csv)
+{
+    size_t capacity = 1 << 16;
+    size_t size = 0;
+    char *data = (char *)emalloc(capacity);
+    ssize_t n;
+
+    while ((n = read(fd, data + size, capacity - size)) > 0)
+    {
+        size += (size_t)n;
+        if (size == capacity)
+        {
+            char *bigger = (char *)emalloc(capacity * 2);
+            memcpy(bigger, data, size);
+            free(data);
+            data = bigger;
+            capacity *= 2;
+        }
+    }
+
+    csv->data = data;
+    csv->size = size;
+    csv->mapped = 0;
+}
+
+/**
+ * Function:  csv_open
+ * -------------------
+ * @brief  Allows to open a CSV file and map it into memory.
+ *
+ * @param filename The path of the file to open.
+ *
+ * @return csv_file_t* A reader positioned at the first line, or NULL if the file cannot be opened.
+ *
+ */
+csv_file_t *csv_open(const char *filename)
+{
+    struct stat st;
+    csv_file_t *csv;
+    int fd = open(filename, O_RDONLY);
+
+    if (fd < 0)
+    {
+        return NULL;
+    }
+
+    csv = (csv_file_t *)emalloc(sizeof(csv_file_t));
+    csv->pos = 0;
+    csv->data = MAP_FAILED;
+
+    if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0)
+    {
+        csv->data = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    }
+    if (csv->data != MAP_FAILED)
+    {
+        csv->size = (size_t)st.st_size;
+        csv->mapped = 1;
+        madvise((void *)csv->data, csv->size, MADV_SEQUENTIAL);
+    }
+    else
+    {
+        read_all(fd, csv);
+    }
+
+    /* skip the UTF-8 byte order mark */
+    if (csv->size >= 3 && memcmp(csv->data, "\xEF\xBB\xBF", 3) == 0)
+    {
+        csv->pos = 3;
+    }
+
+    csv->borrowed = 0;
+    csv->scanner = csv_best_scanner();
+    csv->separators = (size_t *)emalloc(SCAN_WINDOW * sizeof(size_t));
+    csv->num_separators = 0;
+    csv->next_separator = 0;
+    csv->scanned = csv->pos;
+    csv->in_quote = 0;
+
+    close(fd);
+    return csv;
+}
+
+/**
+ * Function:  csv_use_scanner
+ * --------------------------
+ * @brief  Allows to choose the kernel used to find field separators.
+ *
+ * csv_open() picks the fastest kernel the CPU supports; this is meant for
+ * checking the kernels against each other. It must be called before the
+ * first row is read.
+ *
+ * @param csv The reader.
+ * @param scanner The kernel to use.
+ *
+ */
+void csv_use_scanner(csv_file_t *csv, csv_scanner_t scanner)
+{
+    if (csv_scanner_supported(scanner))
+    {
+        csv->scanner = scanner;
+    }
+}
+
+/**
+ * @brief Scan the next window of the file into the separator index.
+ *
+ * @param csv The reader; its index must have been used up.
+ * @return int 1 if a window was scanned, 0 if the whole file has been scanned already.
+ */
+static int scan_window(csv_file_t *csv)
+{
+    size_t to;
+
+    if (csv->scanned >= csv->size)
+    {
+        return 0;
+    }
+
+    to = csv->size - csv->scanned < SCAN_WINDOW ? csv->size : csv->scanned + SCAN_WINDOW;
+    csv->num_separators = csv_scan(csv->scanner, csv->data, csv->scanned, to, &csv->in_quote, csv->separators);
+    csv->next_separator = 0;
+    csv->scanned = to;
+    return 1;
+}
+
+/**
+ * @brief Store the field found between two separators.
+ *
+ * A field that starts with a quote is reduced to the characters between the
+ * opening quote and the last quote of the field; anything between the closing
+ * quote and the separator is ignored. The CR of a CRLF row ending is dropped.
+ *
+ * @param start The first character of the field.
+ * @param end The separator (or the end of the file) after the field.
+ */
+static void add_field(csv_field_t *fields, int max_fields, int *num_fields, const char *start, const char *end)
+{
+    csv_field_t *field;
+
+    if ((*num_fields)++ >= max_fields)
+    {
+        return;
+    }
+
+    field = &fields[*num_fields - 1];
+    field->escaped = 0;
+    if (start < end && *start == '"')
+    {
+        const char *close = memrchr(start + 1, '"', end - start - 1);
+        field->start = start + 1;
+        field->len = (close != NULL ? close : end) - field->start;
+        field->escaped = memchr(field->start, '"', field->len) != NULL;
+        return;
+    }
+
+    if (start < end && end[-1] == '\r')
+    {
+        end--;
+    }
+    field->start = start;
+    field->len = end - start;
+}
+
+/**
+ * Function:  csv_next_row
+ * -----------------------
+ * @brief  Allows to get the fields of the next row without copying them.
+ *
+ * Rows are split following RFC 4180: fields are separated by commas, may be
+ * empty, may be quoted (and then hold commas, newlines and `""` escapes), and
+ * rows end with either LF or CRLF. The fields are cut at the separator offsets
+ * found by the vectorized scanner, so the bytes of a field are never looked at
+ * one by one unless it is quoted.
+ *
+ * @param csv The reader.
+ * @param fields The array to store the fields in.
+ * @param max_fields The size of `fields`; further fields are counted but not stored.
+ * @param num_fields Set to the number of fields in the row.
+ *
+ * @return int 1 if a row was returned, 0 at the end of the file.
+ *
+ */
+int csv_next_row(csv_file_t *csv, csv_field_t *fields, int max_fields, int *num_fields)
+{
+    const char *field = csv->data + csv->pos;
+
+    *num_fields = 0;
+    if (csv->pos >= csv->size)
+    {
+        return 0;
+    }
+
+    for (;;)
+    {
+        if (csv->next_separator == csv->num_separators && !scan_window(csv))
+        {
+            /* the last row has no newline */
+            add_field(fields, max_fields, num_fields, field, csv->data + csv->size);
+            csv->pos = csv->size;
+            return 1;
+        }
+        if (csv->next_separator == csv->num_separators)
+        {
+            continue;
+        }
+
+        const char *separator = csv->data + csv->separators[csv->next_separator++];
+        add_field(fields, max_fields, num_fields, field, separator);
+        field = separator + 1;
+        if (*separator == '\n')
+        {
+            csv->pos = field - csv->data;
+            return 1;
+        }
+    }
+}
+
+/**
+ * @brief Find the first row that starts at or after an offset.
+ *
+ * @param csv The reader.
+ * @param from The offset to start looking from; it must not be 0.
+ * @param in_quote Whether the quotes before `from - 1` leave a quoted field open.
+ * @return The offset of the row start, or the size of the file if there is none.
+ */
+static size_t find_row_start(csv_file_t *csv, size_t from, int in_quote)
+{
+    size_t separators[SCAN_BLOCK];
+    uint64_t state = in_quote ? ~(uint64_t)0 : 0;
+    size_t offset = from - 1;
+
+    /* a row starts right after a newline that is not inside a quoted field */
+    while (offset < csv->size)
+    {
+        size_t to = csv->size - offset < SCAN_BLOCK ? csv->size : offset + SCAN_BLOCK;
+        size_t count = csv_scan(csv->scanner, csv->data, offset, to, &state, separators);
+
+        for (size_t i = 0; i < count; i++)
+        {
+            if (csv->data[separators[i]] == '\n')
+            {
+                return separators[i] + 1;
+            }
+        }
+        offset = to;
+    }
+    return csv->size;
+}
+
+/**
+ * Function:  csv_split
+ * --------------------
+ * @brief  Allows to split the rest of the file into parts that start and end on row boundaries.
+ *
+ * The remaining rows are cut into `parts` ranges of about the same size. Each
+ * cut is moved forward to the next row start, taking quoted fields (which may
+ * hold newlines) into account, so every range can be read on its own with
+ * csv_slice(). Some ranges may be empty when the file is small.
+ *
+ * @param csv The reader, positioned at the first row to split.
+ * @param parts The number of ranges wanted.
+ * @param bounds An array of `parts + 1` offsets; range i is bounds[i] to bounds[i + 1].
+ *
+ * @return int The number of ranges, `parts`.
+ *
+ */
+int csv_split(csv_file_t *csv, int parts, size_t *bounds)
+{
+    size_t remaining = csv->size - csv->pos;
+    size_t counted = 0;
+    int quotes = 0;
+
+    bounds[0] = csv->pos;
+    for (int i = 1; i < parts; i++)
+    {
+        size_t cut = csv->pos + remaining / parts * i;
+
+        if (cut <= bounds[i - 1])
+        {
+            bounds[i] = bounds[i - 1];
+            continue;
+        }
+
+        /* the quote parity before the cut tells whether it is inside a quoted field */
+        for (const char *quote = csv->data + counted;
+             (quote = memchr(quote, '"', cut - 1 - (quote - csv->data))) != NULL; quote++)
+        {
+            quotes++;
+        }
+        counted = cut - 1;
+
+        bounds[i] = find_row_start(csv, cut, quotes % 2);
+    }
+    bounds[parts] = csv->size;
+    return parts;
+}
+
+/**
+ * Function:  csv_slice
+ * --------------------
+ * @brief  Allows to get a reader over a range of rows of the file.
+ *
+ * The new reader shares the data of `csv`, so it must be closed before `csv`.
+ * Several slices can be read at the same time from different threads.
+ *
+ * @param csv The reader to cut the range from.
+ * @param from The offset of the first row of the range.
+ * @param to The offset just past the last row of the range.
+ *
+ * @return csv_file_t* A reader over the rows of the range.
+ *
+ */
+csv_file_t *csv_slice(csv_file_t *csv, size_t from, size_t to)
+{
+    csv_file_t *slice = (csv_file_t *)emalloc(sizeof(csv_file_t));
+
+    slice->data = csv->data;
+    slice->size = to;
+    slice->pos = from;
+    slice->mapped = csv->mapped;
+    slice->borrowed = 1;
+    slice->scanner = csv->scanner;
+    slice->separators = (size_t *)emalloc(SCAN_WINDOW * sizeof(size_t));
+    slice->num_separators = 0;
+    slice->next_separator = 0;
+    slice->scanned = from;
+    slice->in_quote = 0;
+
+    return slice;
+}
+
+/**
+ * Function:  csv_number
+ * ---------------------
+ * @brief  Allows to copy a numeric field into a NUL-terminated buffer so it can be converted.
+ *
+ * A field longer than the buffer is cut short.
+ *
+ * @param buffer The buffer to fill in.
+ * @param size The size of the buffer.
+ * @param field The field to copy.
+ *
+ * @return char* The buffer.
+ *
+ */
+char *csv_number(char *buffer, size_t size, const csv_field_t *field)
+{
+    size_t len = field->len < size ? field->len : size - 1;
+
+    memcpy(buffer, field->start, len);
+    buffer[len] = '\0';
+    return buffer;
+}
+
+/**
+ * Function:  csv_close
+ * --------------------
+ * @brief  Allows to unmap the file and release the reader.
+ *
+ * Any line or field obtained from the reader becomes invalid.
+ *
+ * @param csv The reader to close.
+ *
+ */
+void csv_close(csv_file_t *csv)
+{
+    free(csv->separators);
+    if (csv->borrowed)
+    {
+        /* the data belongs to the reader the slice was cut from */
+    }
+    else if (csv->mapped)
+    {
+        munmap((void *)csv->data, csv->size);
+    }
+    else
+    {
+        free((void *)csv->data);
+    }
+    free(csv);
+}
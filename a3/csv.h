@@ -0,0 +1,59 @@
+/** @file csv.h
+ *  @brief Function prototypes for the memory-mapped CSV reader.
+ */
+#ifndef _CSV_H_
+#define _CSV_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include "csv_scan.h"
+
+/**
+ * @brief An input file mapped into memory and a cursor over its rows.
+ *
+ * The file is scanned a window at a time into `separators`, the offsets of the
+ * commas and newlines that end each field (see csv_scan.h). Fields handed out
+ * by csv_next_row() point straight into `data`, so they stay valid (and nothing
+ * needs to be copied) until the file is closed. A reader made by csv_slice()
+ * only covers the rows from `pos` up to `size`, and borrows `data` from the
+ * reader it was cut from.
+ */
+typedef struct csv_file {
+    const char *data;
+    size_t size;
+    size_t pos;
+    int mapped;
+    int borrowed;
+    csv_scanner_t scanner;
+    size_t *separators;
+    size_t num_separators;
+    size_t next_separator;
+    size_t scanned;
+    uint64_t in_quote;
+} csv_file_t;
+
+/**
+ * @brief A view of one field of a row.
+ *
+ * For a quoted field the view covers the characters between the quotes. If the
+ * field contained escaped quotes, `escaped` is set and every `""` in the view
+ * stands for a single `"`.
+ */
+typedef struct csv_field {
+    const char *start;
+    size_t len;
+    int escaped;
+} csv_field_t;
+
+/**
+ * Function protypes associated with the CSV reader.
+ */
+csv_file_t *csv_open(const char *filename);
+void csv_use_scanner(csv_file_t *csv, csv_scanner_t scanner);
+int csv_split(csv_file_t *csv, int parts, size_t *bounds);
+csv_file_t *csv_slice(csv_file_t *csv, size_t from, size_t to);
+int csv_next_row(csv_file_t *csv, csv_field_t *fields, int max_fields, int *num_fields);
+char *csv_number(char *buffer, size_t size, const csv_field_t *field);
+void csv_close(csv_file_t *csv);
+
+#endif
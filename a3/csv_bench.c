@@ -0,0 +1,194 @@
+/** @file csv_bench.c
+ *  @brief A benchmark comparing the CSV tokenizer against the old fgets/strtok loop.
+ *
+ * Both loops extract the same columns music_manager needs (artist, song, year,
+ * popularity, danceability and energy) from every row of the given file, and
+ * each one is timed over several runs; the best run is reported. The tokenizer
+ * is run once with every separator scanner the CPU supports, after checking
+ * that they all find exactly the same separators.
+ *
+ * Usage: ./csv_bench FILE [RUNS]
+ *
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "csv.h"
+#include "csv_scan.h"
+
+#define NUM_FIELDS 8
+
+/**
+ * @brief The values extracted from every row, summed so the work is not optimized away.
+ */
+typedef struct checksum {
+    long rows;
+    long text_len;
+    long years;
+    long popularity;
+    double danceability;
+    double energy;
+} checksum_t;
+
+/**
+ * @brief Get the current time in seconds from a monotonic clock.
+ */
+static double now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/**
+ * @brief Parse the file the way music_manager used to: fgets() into a line buffer, then strtok().
+ */
+static void run_strtok(const char *filename, checksum_t *sum)
+{
+    FILE *file = fopen(filename, "r");
+    char line[1024];
+
+    fgets(line, sizeof(line), file);
+    while (fgets(line, sizeof(line), file) != NULL) {
+        line[strcspn(line, "\n")] = '\0';
+        char *artist = strtok(line, ",");
+        char *song = strtok(NULL, ",");
+        strtok(NULL, ",");
+        strtok(NULL, ",");
+        char *year = strtok(NULL, ",");
+        char *popularity = strtok(NULL, ",");
+        char *danceability = strtok(NULL, ",");
+        char *energy = strtok(NULL, ",");
+        if (energy == NULL) {
+            continue;
+        }
+        sum->rows++;
+        sum->text_len += strlen(artist) + strlen(song);
+        sum->years += atoi(year);
+        sum->popularity += atoi(popularity);
+        sum->danceability += atof(danceability);
+        sum->energy += atof(energy);
+    }
+
+    fclose(file);
+}
+
+/**
+ * @brief The scanner used by run_tokenizer().
+ */
+static csv_scanner_t scanner = SCAN_SCALAR;
+
+/**
+ * @brief Parse the file with the memory-mapped RFC 4180 tokenizer.
+ */
+static void run_tokenizer(const char *filename, checksum_t *sum)
+{
+    csv_file_t *csv = csv_open(filename);
+    csv_use_scanner(csv, scanner);
+    csv_field_t fields[NUM_FIELDS];
+    int num_fields;
+    char number[64];
+
+    csv_next_row(csv, fields, NUM_FIELDS, &num_fields);
+    while (csv_next_row(csv, fields, NUM_FIELDS, &num_fields)) {
+        if (num_fields < NUM_FIELDS) {
+            continue;
+        }
+        sum->rows++;
+        sum->text_len += fields[0].len + fields[1].len;
+        sum->years += atoi(csv_number(number, sizeof(number), &fields[4]));
+        sum->popularity += atoi(csv_number(number, sizeof(number), &fields[5]));
+        sum->danceability += atof(csv_number(number, sizeof(number), &fields[6]));
+        sum->energy += atof(csv_number(number, sizeof(number), &fields[7]));
+    }
+
+    csv_close(csv);
+}
+
+/**
+ * @brief Check that every supported scanner finds the same separators as the scalar one.
+ *
+ * @return int 1 if they all agree, 0 otherwise.
+ */
+static int verify_scanners(const char *filename)
+{
+    csv_file_t *csv = csv_open(filename);
+    size_t *expected = malloc((csv->size + 1) * sizeof(size_t));
+    size_t *found = malloc((csv->size + 1) * sizeof(size_t));
+    uint64_t in_quote = 0;
+    size_t count = csv_scan(SCAN_SCALAR, csv->data, 0, csv->size, &in_quote, expected);
+    int ok = 1;
+
+    for (csv_scanner_t kernel = SCAN_SSE2; kernel <= SCAN_AVX2; kernel++) {
+        if (!csv_scanner_supported(kernel)) {
+            continue;
+        }
+        in_quote = 0;
+        size_t n = csv_scan(kernel, csv->data, 0, csv->size, &in_quote, found);
+        if (n != count || memcmp(found, expected, count * sizeof(size_t)) != 0) {
+            printf("scanner %s disagrees with scalar\n", csv_scanner_name(kernel));
+            ok = 0;
+        }
+    }
+
+    free(expected);
+    free(found);
+    csv_close(csv);
+    return ok;
+}
+
+/**
+ * @brief Time the best of `runs` runs of a parsing loop and print the result.
+ */
+static double bench(const char *name, void (*run)(const char *, checksum_t *), const char *filename, int runs)
+{
+    double best = -1;
+    checksum_t sum;
+
+    for (int i = 0; i < runs; i++) {
+        memset(&sum, 0, sizeof(sum));
+        double start = now();
+        run(filename, &sum);
+        double elapsed = now() - start;
+        if (best < 0 || elapsed < best) {
+            best = elapsed;
+        }
+    }
+
+    printf("%-10s %8.2f ms  %10ld rows  %8.1f Mrows/s  (checksum %ld %ld %.3f %.3f)\n",
+           name, best * 1e3, sum.rows, sum.rows / best / 1e6,
+           sum.years, sum.popularity, sum.danceability, sum.energy);
+    return best;
+}
+
+/**
+ * @brief The main function and entry point of the benchmark.
+ *
+ * @param argc The number of arguments passed to the program.
+ * @param argv The list of arguments passed to the program.
+ * @return int 0: No errors; 1: Errors produced.
+ *
+ */
+int main(int argc, char *argv[])
+{
+    if (argc < 2) {
+        fprintf(stderr, "usage: %s FILE [RUNS]\n", argv[0]);
+        return 1;
+    }
+    int runs = argc > 2 ? atoi(argv[2]) : 5;
+
+    if (!verify_scanners(argv[1])) {
+        return 1;
+    }
+
+    double old = bench("strtok", run_strtok, argv[1], runs);
+    for (scanner = SCAN_SCALAR; scanner <= SCAN_AVX2; scanner++) {
+        if (csv_scanner_supported(scanner)) {
+            double new = bench(csv_scanner_name(scanner), run_tokenizer, argv[1], runs);
+            printf("speedup    %8.2fx\n", old / new);
+        }
+    }
+    return 0;
+}
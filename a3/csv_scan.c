@@ -0,0 +1,238 @@
+/** @file csv_scan.c
+ *  @brief Implementation of a vectorized CSV field-boundary scanner.
+ *
+ * The input is classified 64 bytes at a time into bitmasks of quotes, commas
+ * and newlines. A prefix XOR of the quote mask gives the bytes that are inside
+ * quotes, and the commas and newlines outside of them are the field separators.
+ * Only the classification differs between the scalar, SSE2 and AVX2 kernels,
+ * so they all produce exactly the same separators.
+ *
+ */
+#include <string.h>
+#include "csv_scan.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#define SCAN_X86 1
+#include <immintrin.h>
+#endif
+
+/**
+ * @brief Bitmasks of the interesting characters of a 64-byte block (bit i is byte i).
+ */
+typedef struct block_masks {
+    uint64_t quotes;
+    uint64_t commas;
+    uint64_t newlines;
+} block_masks_t;
+
+/**
+ * @brief Classify a block one byte at a time.
+ */
+static void classify_scalar(const char *block, block_masks_t *masks)
+{
+    masks->quotes = 0;
+    masks->commas = 0;
+    masks->newlines = 0;
+    for (int i = 0; i < SCAN_BLOCK; i++) {
+        uint64_t bit = (uint64_t)1 << i;
+        if (block[i] == '"') {
+            masks->quotes |= bit;
+        } else if (block[i] == ',') {
+            masks->commas |= bit;
+        } else if (block[i] == '\n') {
+            masks->newlines |= bit;
+        }
+    }
+}
+
+#ifdef SCAN_X86
+/**
+ * @brief Classify a block with four 16-byte SSE2 compares per character.
+ */
+static void classify_sse2(const char *block, block_masks_t *masks)
+{
+    const __m128i quote = _mm_set1_epi8('"');
+    const __m128i comma = _mm_set1_epi8(',');
+    const __m128i newline = _mm_set1_epi8('\n');
+
+    masks->quotes = 0;
+    masks->commas = 0;
+    masks->newlines = 0;
+    for (int i = 0; i < SCAN_BLOCK; i += 16) {
+        __m128i bytes = _mm_loadu_si128((const __m128i *)(block + i));
+        masks->quotes |= (uint64_t)(uint16_t)_mm_movemask_epi8(_mm_cmpeq_epi8(bytes, quote)) << i;
+        masks->commas |= (uint64_t)(uint16_t)_mm_movemask_epi8(_mm_cmpeq_epi8(bytes, comma)) << i;
+        masks->newlines |= (uint64_t)(uint16_t)_mm_movemask_epi8(_mm_cmpeq_epi8(bytes, newline)) << i;
+    }
+}
+
+/**
+ * @brief Classify a block with two 32-byte AVX2 compares per character.
+ */
+__attribute__((target("avx2")))
+static void classify_avx2(const char *block, block_masks_t *masks)
+{
+    const __m256i quote = _mm256_set1_epi8('"');
+    const __m256i comma = _mm256_set1_epi8(',');
+    const __m256i newline = _mm256_set1_epi8('\n');
+    __m256i lo = _mm256_loadu_si256((const __m256i *)block);
+    __m256i hi = _mm256_loadu_si256((const __m256i *)(block + 32));
+
+    masks->quotes = (uint64_t)(uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(lo, quote)) |
+                    (uint64_t)(uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(hi, quote)) << 32;
+    masks->commas = (uint64_t)(uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(lo, comma)) |
+                    (uint64_t)(uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(hi, comma)) << 32;
+    masks->newlines = (uint64_t)(uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(lo, newline)) |
+                      (uint64_t)(uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(hi, newline)) << 32;
+}
+#endif
+
+/**
+ * @brief Turn a mask of quotes into a mask of the bytes between an opening and a closing quote.
+ *
+ * Bit i of the result is the parity of the quotes at positions 0..i, so an
+ * escaped quote (`""`) switches the state off and straight back on.
+ */
+static uint64_t prefix_xor(uint64_t mask)
+{
+    mask ^= mask << 1;
+    mask ^= mask << 2;
+    mask ^= mask << 4;
+    mask ^= mask << 8;
+    mask ^= mask << 16;
+    mask ^= mask << 32;
+    return mask;
+}
+
+/**
+ * Function:  csv_scanner_supported
+ * --------------------------------
+ * @brief  Allows to check whether a kernel can run on this CPU.
+ *
+ * @param scanner The kernel to check.
+ *
+ * @return int 1 if the kernel can be used, 0 otherwise.
+ *
+ */
+int csv_scanner_supported(csv_scanner_t scanner)
+{
+    switch (scanner) {
+    case SCAN_SCALAR:
+        return 1;
+#ifdef SCAN_X86
+    case SCAN_SSE2:
+        return __builtin_cpu_supports("sse2");
+    case SCAN_AVX2:
+        return __builtin_cpu_supports("avx2");
+#endif
+    default:
+        return 0;
+    }
+}
+
+/**
+ * Function:  csv_best_scanner
+ * ---------------------------
+ * @brief  Allows to pick the fastest kernel the CPU supports (as reported by cpuid).
+ *
+ * @return csv_scanner_t The kernel to use.
+ *
+ */
+csv_scanner_t csv_best_scanner(void)
+{
+    if (csv_scanner_supported(SCAN_AVX2)) {
+        return SCAN_AVX2;
+    }
+    if (csv_scanner_supported(SCAN_SSE2)) {
+        return SCAN_SSE2;
+    }
+    return SCAN_SCALAR;
+}
+
+/**
+ * Function:  csv_scanner_name
+ * ---------------------------
+ * @brief  Allows to get a printable name for a kernel.
+ *
+ * @param scanner The kernel.
+ *
+ * @return const char* The name of the kernel.
+ *
+ */
+const char *csv_scanner_name(csv_scanner_t scanner)
+{
+    switch (scanner) {
+    case SCAN_SSE2:
+        return "sse2";
+    case SCAN_AVX2:
+        return "avx2";
+    default:
+        return "scalar";
+    }
+}
+
+/**
+ * Function:  csv_scan
+ * -------------------
+ * @brief  Allows to find the field separators in a range of the input.
+ *
+ * Separators are the commas and newlines that are not inside a quoted field.
+ * The range is processed in 64-byte blocks; a last, partial block is copied to
+ * a padded buffer so no kernel reads past `to`.
+ *
+ * @param scanner The kernel to classify the blocks with.
+ * @param data The input.
+ * @param from The offset of the first byte to scan.
+ * @param to The offset just past the last byte to scan.
+ * @param in_quote The quote state carried between calls: 0 outside quotes, all ones inside.
+ *                 Start at 0 and pass the same variable for consecutive ranges.
+ * @param separators The array to store the offsets of the separators in; it must have
+ *                   room for `to - from` entries.
+ *
+ * @return size_t The number of separators found.
+ *
+ */
+size_t csv_scan(csv_scanner_t scanner, const char *data, size_t from, size_t to,
+                uint64_t *in_quote, size_t *separators)
+{
+    char padded[SCAN_BLOCK];
+    block_masks_t masks;
+    size_t count = 0;
+
+    for (size_t offset = from; offset < to; offset += SCAN_BLOCK) {
+        const char *block = data + offset;
+        uint64_t valid = ~(uint64_t)0;
+
+        if (to - offset < SCAN_BLOCK) {
+            memset(padded, 0, sizeof(padded));
+            memcpy(padded, block, to - offset);
+            block = padded;
+            valid = ((uint64_t)1 << (to - offset)) - 1;
+        }
+
+        switch (scanner) {
+#ifdef SCAN_X86
+        case SCAN_AVX2:
+            classify_avx2(block, &masks);
+            break;
+        case SCAN_SSE2:
+            classify_sse2(block, &masks);
+            break;
+#endif
+        default:
+            classify_scalar(block, &masks);
+            break;
+        }
+
+        uint64_t quoted = prefix_xor(masks.quotes) ^ *in_quote;
+        uint64_t found = (masks.commas | masks.newlines) & ~quoted & valid;
+        *in_quote = (uint64_t)0 - (quoted >> 63);
+
+        while (found != 0) {
+            separators[count++] = offset + (size_t)__builtin_ctzll(found);
+            found &= found - 1;
+        }
+    }
+
+    return count;
+}
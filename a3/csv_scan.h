@@ -0,0 +1,33 @@
+/** @file csv_scan.h
+ *  @brief Function prototypes for the vectorized CSV field-boundary scanner.
+ */
+#ifndef _CSV_SCAN_H_
+#define _CSV_SCAN_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @brief The number of bytes classified at once; every kernel works on 64-byte blocks.
+ */
+#define SCAN_BLOCK 64
+
+/**
+ * @brief The available implementations of the block classifier.
+ */
+typedef enum csv_scanner {
+    SCAN_SCALAR,
+    SCAN_SSE2,
+    SCAN_AVX2
+} csv_scanner_t;
+
+/**
+ * Function protypes associated with the scanner.
+ */
+csv_scanner_t csv_best_scanner(void);
+int csv_scanner_supported(csv_scanner_t scanner);
+const char *csv_scanner_name(csv_scanner_t scanner);
+size_t csv_scan(csv_scanner_t scanner, const char *data, size_t from, size_t to,
+                uint64_t *in_quote, size_t *separators);
+
+#endif
@@ -8,118 +8,357 @@
  *  @author Shiyu Tang
  *
  */
+#include <pthread.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
-#include "list.h"
+#include <unistd.h>
 #include "emalloc.h"
+#include "song_table.h"
+#include "topk.h"
+#include "csv.h"
 
-#define MAX_LINE_LEN 80
+/**
+ * @brief The smallest part of the file worth handing to a thread of its own.
+ */
+#define MIN_CHUNK_SIZE (1 << 20)
+
+/**
+ * @brief How the songs are ordered (see --sortMode).
+ */
+typedef enum sort_mode {
+    SORT_HEAP,
+    SORT_FULL,
+    SORT_RADIX
+} sort_mode_t;
 
-void free_list(node_t *list);
-void process_file(node_t **list, char *line, char *sort_By, int display);
-void read_csv(char *argv[]);
-void generate_output_csv(node_t *list, const char *sort_By, int display);
+/**
+ * @brief A range of rows of the input and the songs loaded from it by one thread.
+ */
+typedef struct chunk_job {
+    csv_file_t *csv;
+    ranks_before_t ranks_before;
+    int display;
+    sort_mode_t sort_mode;
+    song_table_t *songs;
+    int *order;
+    int count;
+} chunk_job_t;
+
+void read_csv(int argc, char *argv[]);
+song_table_t *load_chunks(csv_file_t *csv, const char *sort_By, int display, sort_mode_t sort_mode, int threads,
+                          int **order, int *count);
+void *load_chunk(void *arg);
+song_table_t *load_sorted(csv_file_t *csv, ranks_before_t ranks_before, sort_mode_t sort_mode, int **order, int *count);
+song_table_t *load_top_songs(csv_file_t *csv, ranks_before_t ranks_before, int display, int **order, int *count);
+void generate_output_csv(song_table_t *table, int *order, int count, const char *sort_By, int display);
 
 /**
  * @brief Read and process a CSV file based on the command-line arguments.
  *
+ * By default only the best `display` songs are kept while streaming the file
+ * (see topk.h). Passing --sortMode=full loads and sorts every row instead, which
+ * is useful to cross-check the results of the streaming path, and --sortMode=radix
+ * does the same with a radix sort on the column values. --threads=N sets
+ * how many threads parse the file (by default, one per core).
+ *
+ * @param argc The number of arguments passed to the program.
  * @param argv The list of arguments passed to the program.
  */
-void read_csv(char *argv[]) {
-    strtok(argv[3], "=");
-    char* filename = strtok(NULL, "=");
-    strtok(argv[2],"=");
-    int display = atoi(strtok(NULL, "="));
-    strtok(argv[1],"=");
-    char *sort_By = strtok(NULL, "=");
+void read_csv(int argc, char *argv[]) {
+    char *filename = NULL;
+    char *sort_By = NULL;
+    sort_mode_t sort_mode = SORT_HEAP;
+    int display = 0;
+    int threads = (int)sysconf(_SC_NPROCESSORS_ONLN);
 
-    FILE *file = fopen(filename, "r");
-    char line[1024];
-    node_t* list = NULL;
+    for (int i = 1; i < argc; i++) {
+        char *option = strtok(argv[i], "=");
+        char *value = strtok(NULL, "=");
+        if (value == NULL) {
+            continue;
+        }
+        if (strcmp(option, "--files") == 0) {
+            filename = value;
+        } else if (strcmp(option, "--display") == 0) {
+            display = atoi(value);
+        } else if (strcmp(option, "--sortBy") == 0) {
+            sort_By = value;
+        } else if (strcmp(option, "--sortMode") == 0) {
+            if (strcmp(value, "full") == 0) {
+                sort_mode = SORT_FULL;
+            } else if (strcmp(value, "radix") == 0) {
+                sort_mode = SORT_RADIX;
+            } else {
+                sort_mode = SORT_HEAP;
+            }
+        } else if (strcmp(option, "--threads") == 0) {
+            threads = atoi(value);
+        }
+    }
+    if (filename == NULL || sort_By == NULL) {
+        return;
+    }
 
-    fgets(line,sizeof(line),file);
-   
-    while (fgets(line, sizeof(line), file) != NULL) {
-        line[strcspn(line, "\n")] = '\0';
-        process_file(&list, line,sort_By,display);
+    csv_file_t *csv = csv_open(filename);
+    if (csv == NULL) {
+        fprintf(stderr, "unable to open %s\n", filename);
+        exit(1);
     }
 
-    fclose(file);
-    generate_output_csv(list,sort_By,display);
-    free_list(list);
+    csv_field_t header[NUM_FIELDS];
+    int num_fields;
+    csv_next_row(csv, header, NUM_FIELDS, &num_fields);
+
+    int *order;
+    int count;
+    song_table_t *table = load_chunks(csv, sort_By, display, sort_mode, threads, &order, &count);
+
+    // The songs point into the mapped file, so it has to stay open until they are written.
+    generate_output_csv(table, order, count, sort_By, display);
+    free(order);
+    table_free(table);
+    csv_close(csv);
 }
 
 /**
- * @brief Process a line from the CSV file and add a new node to the linked list.
+ * @brief Load the songs of the CSV file using several threads.
+ *
+ * The rows are split into about equal chunks on row boundaries (see csv_split()).
+ * Each thread either sorts its whole chunk or keeps the top `display` songs of it,
+ * and the tables of the threads are then concatenated and their sorted orders
+ * combined with a k-way merge (see merge_songs()). Since the ranking is a total
+ * order, the result is the same as loading the whole file with one thread.
  *
- * @param list The pointer to the linked list.
- * @param line The line read from the CSV file.
+ * @param csv The CSV file, positioned at the first song.
  * @param sort_By The column to sort by.
- * @param display The number of top songs to display.
+ * @param display The number of top songs to keep.
+ * @param sort_mode Whether to keep only the top `display` songs or to sort every song, and how.
+ * @param threads The number of threads to use.
+ * @param order Set to a new array of the rows of the returned table in descending order.
+ * @param count Set to the number of rows in `order`.
+ * @return The table of the loaded songs.
+ */
+song_table_t *load_chunks(csv_file_t *csv, const char *sort_By, int display, sort_mode_t sort_mode, int threads,
+                          int **order, int *count) {
+    // The sort column is resolved once; every comparison then goes straight to its comparator.
+    ranks_before_t ranks_before = song_ranking(sort_By);
+    size_t max_threads = (csv->size - csv->pos) / MIN_CHUNK_SIZE + 1;
+    if (threads < 1) {
+        threads = 1;
+    }
+    if ((size_t)threads > max_threads) {
+        threads = (int)max_threads;
+    }
+
+    size_t *bounds = (size_t *)emalloc((threads + 1) * sizeof(size_t));
+    chunk_job_t *jobs = (chunk_job_t *)emalloc(threads * sizeof(chunk_job_t));
+    pthread_t *workers = (pthread_t *)emalloc(threads * sizeof(pthread_t));
+    int **runs = (int **)emalloc(threads * sizeof(int *));
+    int *lengths = (int *)emalloc(threads * sizeof(int));
+
+    csv_split(csv, threads, bounds);
+    for (int i = 0; i < threads; i++) {
+        jobs[i].csv = csv_slice(csv, bounds[i], bounds[i + 1]);
+        jobs[i].ranks_before = ranks_before;
+        jobs[i].display = display;
+        jobs[i].sort_mode = sort_mode;
+        jobs[i].songs = NULL;
+        jobs[i].order = NULL;
+        jobs[i].count = 0;
+    }
+
+    // The calling thread loads the first chunk itself.
+    for (int i = 1; i < threads; i++) {
+        if (pthread_create(&workers[i], NULL, load_chunk, &jobs[i]) != 0) {
+            fprintf(stderr, "unable to start a thread\n");
+            exit(1);
+        }
+    }
+    load_chunk(&jobs[0]);
+    for (int i = 1; i < threads; i++) {
+        pthread_join(workers[i], NULL);
+    }
+
+    // The first table takes in the rows of the others; their row numbers shift accordingly.
+    song_table_t *table = jobs[0].songs;
+    int total = jobs[0].count;
+    runs[0] = jobs[0].order;
+    lengths[0] = jobs[0].count;
+    for (int i = 1; i < threads; i++) {
+        int base = table->count;
+        table_append(table, jobs[i].songs);
+        for (int j = 0; j < jobs[i].count; j++) {
+            jobs[i].order[j] += base;
+        }
+        runs[i] = jobs[i].order;
+        lengths[i] = jobs[i].count;
+        total += jobs[i].count;
+        table_free(jobs[i].songs);
+    }
+
+    *order = (int *)emalloc(((size_t)total + 1) * sizeof(int));
+    *count = merge_songs(table, runs, lengths, threads, ranks_before, *order, total);
+
+    for (int i = 0; i < threads; i++) {
+        free(jobs[i].order);
+        csv_close(jobs[i].csv);
+    }
+    free(lengths);
+    free(runs);
+    free(workers);
+    free(jobs);
+    free(bounds);
+    return table;
+}
+
+/**
+ * @brief Load the songs of one chunk; the entry point of the worker threads.
+ *
+ * @param arg The chunk_job_t describing the chunk. Its songs are filled in.
+ * @return NULL.
+ */
+void *load_chunk(void *arg) {
+    chunk_job_t *job = (chunk_job_t *)arg;
+
+    if (job->sort_mode != SORT_HEAP) {
+        job->songs = load_sorted(job->csv, job->ranks_before, job->sort_mode, &job->order, &job->count);
+    } else {
+        job->songs = load_top_songs(job->csv, job->ranks_before, job->display, &job->order, &job->count);
+    }
+    return NULL;
+}
+
+/**
+ * @brief Load every song of the CSV file and sort them by the given column.
+ *
+ * @param csv The CSV file, positioned at the first song.
+ * @param ranks_before The comparator of the column to sort by.
+ * @param sort_mode SORT_RADIX to use radix_sort_songs(), otherwise sort_songs() is used.
+ * @param order Set to a new array of the rows of the returned table in descending order.
+ * @param count Set to the number of rows in `order`.
+ * @return The table of all songs.
+ */
+song_table_t *load_sorted(csv_file_t *csv, ranks_before_t ranks_before, sort_mode_t sort_mode, int **order, int *count) {
+    csv_field_t fields[NUM_FIELDS];
+    int num_fields;
+    song_table_t *table = table_create(csv->data, 1024);
+
+    // Bulk load: append every row to the columns, then sort the row indices once.
+    while (csv_next_row(csv, fields, NUM_FIELDS, &num_fields)) {
+        int row = table_next_row(table);
+        if (table_read_row(table, row, fields, num_fields)) {
+            table->count++;
+        }
+    }
+
+    *count = table->count;
+    *order = (int *)emalloc(((size_t)table->count + 1) * sizeof(int));
+    for (int i = 0; i < table->count; i++) {
+        (*order)[i] = i;
+    }
+    if (sort_mode == SORT_RADIX) {
+        radix_sort_songs(table, *order, *count, ranks_before);
+    } else {
+        sort_songs(table, *order, *count, ranks_before);
+    }
+    return table;
+}
+
+/**
+ * @brief Stream the CSV file and keep only the best `display` songs.
+ *
+ * Each row is parsed straight into the scratch row of the selector's table, so
+ * nothing is allocated per row and memory stays O(display) no matter how large
+ * the file is.
+ *
+ * @param csv The CSV file, positioned at the first song.
+ * @param ranks_before The comparator of the column to sort by.
+ * @param display The number of top songs to keep.
+ * @param order Set to a new array of the kept rows of the returned table in descending order.
+ * @param count Set to the number of rows in `order`.
+ * @return The table of the kept songs.
+ */
+song_table_t *load_top_songs(csv_file_t *csv, ranks_before_t ranks_before, int display, int **order, int *count) {
+    csv_field_t fields[NUM_FIELDS];
+    int num_fields;
+    topk_t *heap = topk_create(display, csv->data, ranks_before);
+
+    while (csv_next_row(csv, fields, NUM_FIELDS, &num_fields)) {
+        if (table_read_row(heap->table, topk_candidate(heap), fields, num_fields)) {
+            topk_offer(heap);
+        }
+    }
+
+    return topk_finish(heap, order, count);
+}
+
+/**
+ * @brief Write a field to the output, quoting it when RFC 4180 requires it.
+ *
+ * @param file The output file.
+ * @param text The field.
+ * @param len The length of the field.
+ * @param escaped Whether the quotes in the field are already escaped.
  */
-void process_file(node_t **list, char *line, char *sort_By, int display) {
-    char *token = strtok(line, ",");
-    char *artist = token;
-    char *song = strtok(NULL, ",");
-    token = strtok(NULL, ",");
-    token = strtok(NULL, ",");
-    int year = atoi(strtok(NULL, ","));
-    int popularity = atoi(strtok(NULL, ","));
-    double danceability = atof(strtok(NULL, ","));
-    double energy = atof(strtok(NULL, ","));
-     
-    node_t *new_node_cur = new_node(artist, song, year, danceability, energy, popularity);
-    *list = add_inorder(*list, new_node_cur, sort_By);
+static void write_field(FILE *file, const char *text, int len, int escaped) {
+    int needs_quotes = escaped;
+
+    for (int i = 0; i < len && !needs_quotes; i++) {
+        needs_quotes = (text[i] == ',' || text[i] == '"' || text[i] == '\r' || text[i] == '\n');
+    }
+    if (!needs_quotes) {
+        fwrite(text, 1, len, file);
+        return;
+    }
+
+    fputc('"', file);
+    if (escaped) {
+        fwrite(text, 1, len, file);
+    } else {
+        for (int i = 0; i < len; i++) {
+            if (text[i] == '"') {
+                fputc('"', file);
+            }
+            fputc(text[i], file);
+        }
+    }
+    fputc('"', file);
 }
 
 /**
- * @brief Generate the output CSV file based on the sorted linked list.
+ * @brief Generate the output CSV file based on the sorted order of the song table.
  *
- * @param list The sorted linked list of songs.
+ * @param table The table of songs.
+ * @param order The rows of the table in descending order.
+ * @param count The number of rows in `order`.
  * @param sort_By The column to sort by.
  * @param display The number of top songs to display.
  */
-void generate_output_csv(node_t *list, const char *sort_By, int display) {
+void generate_output_csv(song_table_t *table, int *order, int count, const char *sort_By, int display) {
     FILE *file = fopen("output.csv", "w");
 
     fprintf(file, "artist,song,year,%s\n", sort_By);
 
-    node_t *current = list;
-    int count = 0;
-    while (current != NULL && count < display) {
+    int known_column = strcmp(sort_By, "popularity") == 0 || strcmp(sort_By, "energy") == 0 ||
+                       strcmp(sort_By, "danceability") == 0;
+    for (int i = 0; i < count && i < display && known_column; i++) {
+        int row = order[i];
+        write_field(file, table->text + table->artist[row], table->artist_len[row], table->escaped[row] & ARTIST_ESCAPED);
+        fputc(',', file);
+        write_field(file, table->text + table->song[row], table->song_len[row], table->escaped[row] & SONG_ESCAPED);
         if (strcmp(sort_By, "popularity") == 0) {
-            fprintf(file, "%s,%s,%d,%d\n", current->artist, current->song, current->year, current->popularity);
+            fprintf(file, ",%d,%d\n", table->year[row], table->popularity[row]);
         } else if (strcmp(sort_By, "energy") == 0) {
-            fprintf(file, "%s,%s,%d,%g\n", current->artist, current->song, current->year, current->energy);
+            fprintf(file, ",%d,%g\n", table->year[row], table->energy[row]);
         } else if (strcmp(sort_By, "danceability") == 0) {
-            fprintf(file, "%s,%s,%d,%g\n", current->artist, current->song, current->year, current->danceability);
+            fprintf(file, ",%d,%g\n", table->year[row], table->danceability[row]);
         }
-        current = current->next;
-        count++;
     }
 
     fclose(file);
 }
 
-/**
- * @brief Free the memory allocated for the linked list.
- *
- * @param list The linked list to free.
- */
-void free_list(node_t *list) {
-    node_t *current = list;
-    node_t *next;
-
-    while (current != NULL) {
-        next = current->next;
-        free(current->artist);
-        free(current->song);
-        free(current);
-        current = next;
-    }
-}
-
 /**
  * @brief The main function and entry point of the program.
  *
@@ -131,10 +370,9 @@ void free_list(node_t *list) {
 
 int main(int argc, char *argv[])
 {
-   if(argc != 4){
+   if(argc < 4){
         return 1;
     }
-    read_csv(argv);
-    // TODO: your code.
+    read_csv(argc, argv);
     return 0;
 }
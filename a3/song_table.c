@@ -0,0 +1,713 @@
+/** @file song_table.c
+ *  @brief Implementation of a columnar song table.
+ *
+ */
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "emalloc.h"
+#include "song_table.h"
+
+/**
+ * @brief The size of the arena blocks of a table.
+ */
+#define TABLE_BLOCK_SIZE (1 << 16)
+
+/**
+ * @brief Allocate a copy of a column with room for `capacity` values.
+ *
+ * The old column stays in the arena until the table is freed; since the
+ * capacity doubles, the old columns take at most as much memory as the new ones.
+ */
+static void *grow_column(arena_t *arena, void *column, size_t width, int count, int capacity)
+{
+    void *bigger = arena_alloc(arena, (size_t)capacity * width);
+
+    if (column != NULL)
+    {
+        memcpy(bigger, column, (size_t)count * width);
+    }
+    return bigger;
+}
+
+/**
+ * @brief Make room for at least `capacity` rows in every column.
+ */
+static void reserve_rows(song_table_t *table, int capacity)
+{
+    if (capacity <= table->capacity)
+    {
+        return;
+    }
+    table->artist = grow_column(table->arena, table->artist, sizeof(size_t), table->count, capacity);
+    table->song = grow_column(table->arena, table->song, sizeof(size_t), table->count, capacity);
+    table->artist_len = grow_column(table->arena, table->artist_len, sizeof(int), table->count, capacity);
+    table->song_len = grow_column(table->arena, table->song_len, sizeof(int), table->count, capacity);
+    table->escaped = grow_column(table->arena, table->escaped, sizeof(unsigned char), table->count, capacity);
+    table->year = grow_column(table->arena, table->year, sizeof(int), table->count, capacity);
+    table->popularity = grow_column(table->arena, table->popularity, sizeof(int), table->count, capacity);
+    table->danceability = grow_column(table->arena, table->danceability, sizeof(double), table->count, capacity);
+    table->energy = grow_column(table->arena, table->energy, sizeof(double), table->count, capacity);
+    table->capacity = capacity;
+}
+
+/**
+ * Function:  table_create
+ * -----------------------
+ * @brief  Allows to create an empty song table.
+ *
+ * @param text The input file the artist and song offsets refer to.
+ * @param capacity The number of rows to make room for up front.
+ *
+ * @return song_table_t* A pointer to the new table.
+ *
+ */
+song_table_t *table_create(const char *text, int capacity)
+{
+    arena_t *arena = arena_create(TABLE_BLOCK_SIZE);
+    song_table_t *table = (song_table_t *)arena_alloc(arena, sizeof(song_table_t));
+
+    memset(table, 0, sizeof(song_table_t));
+    table->arena = arena;
+    table->text = text;
+    reserve_rows(table, capacity > 0 ? capacity : 1);
+    return table;
+}
+
+/**
+ * Function:  table_next_row
+ * -------------------------
+ * @brief  Allows to get a free row at the end of the table, growing it if needed.
+ *
+ * The row only becomes part of the table once the caller increments `count`,
+ * so a row that turns out to be invalid can simply be dropped.
+ *
+ * @param table The table.
+ *
+ * @return int The index of the free row.
+ *
+ */
+int table_next_row(song_table_t *table)
+{
+    if (table->count == table->capacity)
+    {
+        reserve_rows(table, table->capacity * 2);
+    }
+    return table->count;
+}
+
+/**
+ * Function:  table_read_row
+ * -------------------------
+ * @brief  Allows to fill in a row of the table from a row of the CSV file.
+ *
+ * The artist and song are stored as offsets into the text of the table, which
+ * must be the file the fields were read from; only the numeric fields are
+ * converted. The row only becomes part of the table once the caller increments
+ * `count` (see table_next_row()).
+ *
+ * @param table The table to fill in.
+ * @param row The row of the table to fill in.
+ * @param fields The fields of the CSV row.
+ * @param num_fields The number of fields in the CSV row.
+ *
+ * @return int 1 if the row holds a song, 0 if it has too few fields.
+ *
+ */
+int table_read_row(song_table_t *table, int row, csv_field_t *fields, int num_fields)
+{
+    char number[64];
+
+    if (num_fields < NUM_FIELDS)
+    {
+        return 0;
+    }
+
+    table->artist[row] = (size_t)(fields[0].start - table->text);
+    table->artist_len[row] = (int)fields[0].len;
+    table->song[row] = (size_t)(fields[1].start - table->text);
+    table->song_len[row] = (int)fields[1].len;
+    table->escaped[row] = (fields[0].escaped ? ARTIST_ESCAPED : 0) | (fields[1].escaped ? SONG_ESCAPED : 0);
+    table->year[row] = atoi(csv_number(number, sizeof(number), &fields[4]));
+    table->popularity[row] = atoi(csv_number(number, sizeof(number), &fields[5]));
+    table->danceability[row] = atof(csv_number(number, sizeof(number), &fields[6]));
+    table->energy[row] = atof(csv_number(number, sizeof(number), &fields[7]));
+
+    return 1;
+}
+
+/**
+ * Function:  table_append
+ * -----------------------
+ * @brief  Allows to append all rows of another table that shares the same text.
+ *
+ * The rows of `other` keep their relative order, shifted by the former `count`.
+ *
+ * @param table The table to append to.
+ * @param other The table whose rows are copied.
+ *
+ */
+void table_append(song_table_t *table, song_table_t *other)
+{
+    int base = table->count;
+    int n = other->count;
+
+    reserve_rows(table, base + n);
+    memcpy(table->artist + base, other->artist, n * sizeof(size_t));
+    memcpy(table->song + base, other->song, n * sizeof(size_t));
+    memcpy(table->artist_len + base, other->artist_len, n * sizeof(int));
+    memcpy(table->song_len + base, other->song_len, n * sizeof(int));
+    memcpy(table->escaped + base, other->escaped, n * sizeof(unsigned char));
+    memcpy(table->year + base, other->year, n * sizeof(int));
+    memcpy(table->popularity + base, other->popularity, n * sizeof(int));
+    memcpy(table->danceability + base, other->danceability, n * sizeof(double));
+    memcpy(table->energy + base, other->energy, n * sizeof(double));
+    table->count += n;
+}
+
+/**
+ * Function:  table_free
+ * ---------------------
+ * @brief  Allows to release a table and all its columns. The text it refers to is not touched.
+ *
+ * @param table The table to free.
+ *
+ */
+void table_free(song_table_t *table)
+{
+    arena_destroy(table->arena);
+}
+
+/**
+ * @brief Get the next character of a view, reading `""` as `"` if the view is escaped.
+ *
+ * @param text The view.
+ * @param len The length of the view.
+ * @param escaped Whether the view holds escaped quotes.
+ * @param i The position in the view, moved past the character.
+ * @return The character as an unsigned char, or -1 at the end of the view.
+ */
+static int next_char(const char *text, int len, int escaped, int *i)
+{
+    unsigned char c;
+
+    if (*i >= len)
+    {
+        return -1;
+    }
+    c = (unsigned char)text[(*i)++];
+    if (escaped && c == '"' && *i < len && text[*i] == '"')
+    {
+        (*i)++;
+    }
+    return c;
+}
+
+/**
+ * Function:  compare_titles
+ * -------------------------
+ * @brief  Allows to compare the titles of two songs the same way strcmp() would.
+ *
+ * @param table The table holding both songs.
+ * @param song1 The row of the first song.
+ * @param song2 The row of the second song.
+ *
+ * @return int A negative value, zero or a positive value if the title of song1 sorts before,
+ *             equal to or after the title of song2.
+ *
+ */
+int compare_titles(song_table_t *table, int song1, int song2)
+{
+    const char *title1 = table->text + table->song[song1];
+    const char *title2 = table->text + table->song[song2];
+    int len1 = table->song_len[song1];
+    int len2 = table->song_len[song2];
+    int escaped1 = table->escaped[song1] & SONG_ESCAPED;
+    int escaped2 = table->escaped[song2] & SONG_ESCAPED;
+    int i = 0;
+    int j = 0;
+    int c1;
+    int c2;
+
+    if (!escaped1 && !escaped2)
+    {
+        int result = memcmp(title1, title2, len1 < len2 ? len1 : len2);
+
+        if (result != 0)
+        {
+            return result;
+        }
+        return len1 - len2;
+    }
+
+    do
+    {
+        c1 = next_char(title1, len1, escaped1, &i);
+        c2 = next_char(title2, len2, escaped2, &j);
+    } while (c1 == c2 && c1 != -1);
+    return c1 - c2;
+}
+
+/**
+ * @brief Define the comparator of one sort column.
+ *
+ * Songs are output in descending order of the column, then in descending order of
+ * their title. Songs that are still equal come out in reverse file order (the song
+ * further down the file first), which is the order the original insertion sort
+ * produced. Since the artist offset grows down the file, this is a total order:
+ * any correct sort gives the same result, whichever way the rows were split.
+ */
+#define DEFINE_RANKS_BEFORE(column)                                             \
+    static int ranks_before_##column(song_table_t *table, int song1, int song2) \
+    {                                                                           \
+        int result;                                                             \
+                                                                                \
+        if (table->column[song1] != table->column[song2])                       \
+        {                                                                       \
+            return table->column[song1] > table->column[song2];                 \
+        }                                                                       \
+        result = compare_titles(table, song1, song2);                           \
+        if (result != 0)                                                        \
+        {                                                                       \
+            return result > 0;                                                  \
+        }                                                                       \
+        return table->artist[song1] > table->artist[song2];                     \
+    }
+
+DEFINE_RANKS_BEFORE(popularity)
+DEFINE_RANKS_BEFORE(energy)
+DEFINE_RANKS_BEFORE(danceability)
+
+/**
+ * @brief The comparator used when the sort column is unknown: title, then file position.
+ */
+static int ranks_before_title(song_table_t *table, int song1, int song2)
+{
+    int result = compare_titles(table, song1, song2);
+
+    if (result != 0)
+    {
+        return result > 0;
+    }
+    return table->artist[song1] > table->artist[song2];
+}
+
+/**
+ * Function:  song_ranking
+ * -----------------------
+ * @brief  Allows to resolve a sort column name into its comparator, once.
+ *
+ * @param required_column The required column to compare the songs by (e.g., "popularity", "energy", "danceability").
+ *
+ * @return ranks_before_t The comparator of the column; songs are only compared by title
+ *                        (then file position) if the column is unknown.
+ *
+ */
+ranks_before_t song_ranking(const char *required_column)
+{
+    if (strcmp(required_column, "popularity") == 0)
+    {
+        return ranks_before_popularity;
+    }
+    else if (strcmp(required_column, "energy") == 0)
+    {
+        return ranks_before_energy;
+    }
+    else if (strcmp(required_column, "danceability") == 0)
+    {
+        return ranks_before_danceability;
+    }
+    return ranks_before_title;
+}
+
+/**
+ * @brief Merge two consecutive sorted runs of row indices into `out`.
+ */
+static void merge_pair(song_table_t *table, const int *left, int left_len, const int *right, int right_len,
+                       int *out, ranks_before_t ranks_before)
+{
+    int i = 0;
+    int j = 0;
+
+    while (i < left_len && j < right_len)
+    {
+        if (ranks_before(table, right[j], left[i]))
+        {
+            *out++ = right[j++];
+        }
+        else
+        {
+            *out++ = left[i++];
+        }
+    }
+    memcpy(out, left + i, (left_len - i) * sizeof(int));
+    memcpy(out + (left_len - i), right + j, (right_len - j) * sizeof(int));
+}
+
+/**
+ * @brief Sort an order (an array of row indices) of a table based on the required column.
+ *
+ * This is a bottom-up merge sort over the indices: runs of width 1, 2, 4, ... are merged
+ * pairwise between the order and a scratch array. Only the indices move; the columns are
+ * read in place.
+ *
+ * @param table The table the indices refer to.
+ * @param order The row indices to sort.
+ * @param count The number of indices.
+ * @param ranks_before The comparator of the sort column (see song_ranking()).
+ */
+void sort_songs(song_table_t *table, int *order, int count, ranks_before_t ranks_before)
+{
+    int *scratch = (int *)emalloc(((size_t)count + 1) * sizeof(int));
+    int *from = order;
+    int *to = scratch;
+
+    for (int width = 1; width < count; width *= 2)
+    {
+        for (int start = 0; start < count; start += 2 * width)
+        {
+            int mid = start + width < count ? start + width : count;
+            int end = start + 2 * width < count ? start + 2 * width : count;
+            merge_pair(table, from + start, mid - start, from + mid, end - mid, to + start, ranks_before);
+        }
+        int *swap = from;
+        from = to;
+        to = swap;
+    }
+
+    if (from != order)
+    {
+        memcpy(order, from, count * sizeof(int));
+    }
+    free(scratch);
+}
+
+/**
+ * @brief The largest range of popularity values sorted with a counting sort.
+ */
+#define MAX_COUNTING_RANGE (1 << 16)
+
+/**
+ * @brief Encode an integer so that comparing the codes as unsigned numbers sorts it descending.
+ */
+static uint64_t int_key(int value)
+{
+    return ~(uint64_t)((uint32_t)value ^ 0x80000000u);
+}
+
+/**
+ * @brief Encode a double so that comparing the codes as unsigned numbers sorts it descending.
+ *
+ * The IEEE 754 bits of a positive double already sort as unsigned integers; the bits of a
+ * negative one sort backwards, so they are all flipped, while positive ones get their sign
+ * bit set to come after the negative ones. -0.0 is folded into 0.0 since they compare equal.
+ */
+static uint64_t double_key(double value)
+{
+    uint64_t bits;
+
+    if (value == 0)
+    {
+        value = 0;
+    }
+    memcpy(&bits, &value, sizeof(bits));
+    bits = (bits & 0x8000000000000000ull) ? ~bits : bits | 0x8000000000000000ull;
+    return ~bits;
+}
+
+/**
+ * @brief Encode the first 8 characters of a title so that the codes sort it descending.
+ *
+ * Titles that share these 8 characters get the same code and are told apart by
+ * compare_titles() afterwards.
+ */
+static uint64_t title_key(song_table_t *table, int row)
+{
+    const char *title = table->text + table->song[row];
+    int len = table->song_len[row];
+    int escaped = table->escaped[row] & SONG_ESCAPED;
+    uint64_t key = 0;
+    int i = 0;
+
+    for (int n = 0; n < 8; n++)
+    {
+        int c = next_char(title, len, escaped, &i);
+        key = (key << 8) | (uint64_t)(c < 0 ? 0 : c);
+    }
+    return ~key;
+}
+
+/**
+ * @brief Sort an order by its keys with an LSD radix sort, one byte per pass.
+ *
+ * Each pass is a stable counting sort on one byte of the keys; passes where every key
+ * has the same byte are skipped, so narrow ranges of values only cost a few passes.
+ */
+static void radix_sort_keys(uint64_t *keys, int *order, int count)
+{
+    uint64_t *keys_to = (uint64_t *)emalloc(((size_t)count + 1) * sizeof(uint64_t));
+    int *order_to = (int *)emalloc(((size_t)count + 1) * sizeof(int));
+    uint64_t *keys_from = keys;
+    int *order_from = order;
+
+    for (int shift = 0; shift < 64; shift += 8)
+    {
+        size_t offsets[256] = {0};
+
+        for (int i = 0; i < count; i++)
+        {
+            offsets[(keys_from[i] >> shift) & 0xff]++;
+        }
+        if (count == 0 || offsets[(keys_from[0] >> shift) & 0xff] == (size_t)count)
+        {
+            continue;
+        }
+        for (size_t byte = 0, total = 0; byte < 256; byte++)
+        {
+            size_t n = offsets[byte];
+            offsets[byte] = total;
+            total += n;
+        }
+        for (int i = 0; i < count; i++)
+        {
+            size_t at = offsets[(keys_from[i] >> shift) & 0xff]++;
+            keys_to[at] = keys_from[i];
+            order_to[at] = order_from[i];
+        }
+
+        uint64_t *swap_keys = keys_from;
+        int *swap_order = order_from;
+        keys_from = keys_to;
+        order_from = order_to;
+        keys_to = swap_keys;
+        order_to = swap_order;
+    }
+
+    if (keys_from != keys)
+    {
+        memcpy(keys, keys_from, count * sizeof(uint64_t));
+        memcpy(order, order_from, count * sizeof(int));
+        free(keys_from);
+        free(order_from);
+    }
+    else
+    {
+        free(keys_to);
+        free(order_to);
+    }
+}
+
+/**
+ * @brief Sort an order by popularity, descending, with a counting sort.
+ *
+ * @return 1 if the order was sorted, 0 if the range of popularity values is too wide.
+ */
+static int counting_sort_popularity(song_table_t *table, int *order, int count, uint64_t *keys)
+{
+    int min = table->popularity[order[0]];
+    int max = min;
+
+    for (int i = 1; i < count; i++)
+    {
+        int value = table->popularity[order[i]];
+        min = value < min ? value : min;
+        max = value > max ? value : max;
+    }
+    if ((long)max - min >= MAX_COUNTING_RANGE)
+    {
+        return 0;
+    }
+
+    size_t *offsets = (size_t *)emalloc(((size_t)(max - min) + 2) * sizeof(size_t));
+    int *sorted = (int *)emalloc(((size_t)count + 1) * sizeof(int));
+
+    memset(offsets, 0, ((size_t)(max - min) + 2) * sizeof(size_t));
+
+    /* bucket b holds the value max - b, so the buckets come out in descending order */
+    for (int i = 0; i < count; i++)
+    {
+        offsets[max - table->popularity[order[i]] + 1]++;
+    }
+    for (long b = 1; b <= (long)max - min + 1; b++)
+    {
+        offsets[b] += offsets[b - 1];
+    }
+    for (int i = 0; i < count; i++)
+    {
+        sorted[offsets[max - table->popularity[order[i]]]++] = order[i];
+    }
+    for (int i = 0; i < count; i++)
+    {
+        order[i] = sorted[i];
+        keys[i] = int_key(table->popularity[sorted[i]]);
+    }
+
+    free(sorted);
+    free(offsets);
+    return 1;
+}
+
+/**
+ * Function:  radix_sort_songs
+ * ---------------------------
+ * @brief  Allows to sort an order of a table without comparing songs by their column.
+ *
+ * The column values and the first characters of the titles are encoded into 64-bit
+ * keys that sort in descending order as unsigned integers. The order is radix sorted
+ * on the title keys first, then on the column: popularity is bucketed with a counting
+ * sort, and energy and danceability are sorted with an LSD radix sort on their
+ * normalized IEEE 754 bits. Both passes are stable, so the songs end up ordered by
+ * column, then by title prefix. Only the runs of songs that share both keys are then
+ * checked, and ordered by full title and file position with sort_songs() if needed,
+ * so the result is exactly the order of the comparator `ranks_before`. An unknown
+ * column falls back to sort_songs().
+ *
+ * @param table The table the indices refer to.
+ * @param order The row indices to sort.
+ * @param count The number of indices.
+ * @param ranks_before The comparator of the sort column (see song_ranking()).
+ */
+void radix_sort_songs(song_table_t *table, int *order, int count, ranks_before_t ranks_before)
+{
+    uint64_t *keys;
+    int is_popularity = ranks_before == ranks_before_popularity;
+
+    if (count < 2 || ranks_before == ranks_before_title)
+    {
+        sort_songs(table, order, count, ranks_before);
+        return;
+    }
+
+    /* rows usually come in file order; reversed, equal songs are already in output order */
+    int ascending = 1;
+    for (int i = 1; i < count && ascending; i++)
+    {
+        ascending = table->artist[order[i - 1]] < table->artist[order[i]];
+    }
+    for (int i = 0, j = count - 1; ascending && i < j; i++, j--)
+    {
+        int swap = order[i];
+        order[i] = order[j];
+        order[j] = swap;
+    }
+
+    keys = (uint64_t *)emalloc((size_t)count * sizeof(uint64_t));
+    for (int i = 0; i < count; i++)
+    {
+        keys[i] = title_key(table, order[i]);
+    }
+    radix_sort_keys(keys, order, count);
+
+    if (!is_popularity || !counting_sort_popularity(table, order, count, keys))
+    {
+        for (int i = 0; i < count; i++)
+        {
+            int row = order[i];
+            keys[i] = is_popularity ? int_key(table->popularity[row])
+                      : ranks_before == ranks_before_energy ? double_key(table->energy[row])
+                                                            : double_key(table->danceability[row]);
+        }
+        radix_sort_keys(keys, order, count);
+    }
+
+    for (int start = 0, end; start < count; start = end)
+    {
+        int sorted = 1;
+        uint64_t title = title_key(table, order[start]);
+
+        end = start + 1;
+        while (end < count && keys[end] == keys[start] && title_key(table, order[end]) == title)
+        {
+            sorted = sorted && ranks_before(table, order[end - 1], order[end]);
+            end++;
+        }
+        if (!sorted)
+        {
+            sort_songs(table, order + start, end - start, ranks_before);
+        }
+    }
+    free(keys);
+}
+
+/**
+ * @brief Restore the heap of run numbers below position `i` (the run with the best head at the root).
+ */
+static void sift_runs(song_table_t *table, int **runs, int *heap, int size, int i, ranks_before_t ranks_before)
+{
+    int run = heap[i];
+
+    for (;;)
+    {
+        int child = 2 * i + 1;
+        if (child >= size)
+        {
+            break;
+        }
+        if (child + 1 < size && ranks_before(table, *runs[heap[child + 1]], *runs[heap[child]]))
+        {
+            child++;
+        }
+        if (!ranks_before(table, *runs[heap[child]], *runs[run]))
+        {
+            break;
+        }
+        heap[i] = heap[child];
+        i = child;
+    }
+    heap[i] = run;
+}
+
+/**
+ * @brief Merge several sorted runs of row indices of a table into one order.
+ *
+ * This is a k-way merge: the heads of the runs are kept in a binary heap, so each row is
+ * placed in O(log k). Because the comparators define a total order, the result is exactly what
+ * sorting all the rows at once would give.
+ *
+ * @param table The table the indices refer to.
+ * @param runs The sorted runs. The pointers are advanced while merging.
+ * @param lengths The number of indices in each run. The lengths are used up while merging.
+ * @param num_runs The number of runs.
+ * @param ranks_before The comparator of the sort column (see song_ranking()).
+ * @param order The array to store the merged indices in.
+ * @param limit The maximum number of indices to output.
+ * @return The number of indices stored in `order`.
+ */
+int merge_songs(song_table_t *table, int **runs, int *lengths, int num_runs, ranks_before_t ranks_before,
+                int *order, int limit)
+{
+    int *heap = (int *)emalloc((num_runs + 1) * sizeof(int));
+    int size = 0;
+    int count = 0;
+
+    for (int i = 0; i < num_runs; i++)
+    {
+        if (lengths[i] > 0)
+        {
+            heap[size++] = i;
+        }
+    }
+    for (int i = size / 2 - 1; i >= 0; i--)
+    {
+        sift_runs(table, runs, heap, size, i, ranks_before);
+    }
+
+    while (size > 0 && count < limit)
+    {
+        int best = heap[0];
+
+        order[count++] = *runs[best]++;
+        if (--lengths[best] == 0)
+        {
+            heap[0] = heap[--size];
+        }
+        if (size > 0)
+        {
+            sift_runs(table, runs, heap, size, 0, ranks_before);
+        }
+    }
+
+    free(heap);
+    return count;
+}
@@ -0,0 +1,73 @@
+/** @file song_table.h
+ *  @brief Function prototypes for the columnar song table.
+ */
+#ifndef _SONG_TABLE_H_
+#define _SONG_TABLE_H_
+
+#include <stddef.h>
+#include "arena.h"
+#include "csv.h"
+
+/**
+ * @brief The number of leading CSV fields a song row needs (artist ... energy).
+ */
+#define NUM_FIELDS 8
+
+/**
+ * @brief Flags of the `escaped` column: the field holds `""` escapes (see csv.h).
+ */
+#define ARTIST_ESCAPED 1
+#define SONG_ESCAPED 2
+
+/**
+ * @brief A table of songs stored column by column.
+ *
+ * Each attribute lives in its own contiguous array, so sorting by one column only
+ * streams through that column. The artist and song are (offset, length) views into
+ * `text`, the mapped input file, which serves as the string arena of the table;
+ * they are only copied when the output is written. Rows are never moved: tables
+ * are sorted through an array of row indices (an order).
+ *
+ * The table and its columns are allocated from the table's own arena, so a
+ * table is released at once no matter how often it grew.
+ */
+typedef struct song_table {
+    arena_t *arena;
+    const char *text;
+    size_t *artist;
+    size_t *song;
+    int *artist_len;
+    int *song_len;
+    unsigned char *escaped;
+    int *year;
+    int *popularity;
+    double *danceability;
+    double *energy;
+    int count;
+    int capacity;
+} song_table_t;
+
+/**
+ * @brief A comparator that tells whether song1 comes before song2 in the output.
+ *
+ * One is generated per sort column (see song_ranking()), so the column name is
+ * resolved once instead of on every comparison.
+ */
+typedef int (*ranks_before_t)(song_table_t *table, int song1, int song2);
+
+/**
+ * Function protypes associated with the song table.
+ */
+song_table_t *table_create(const char *text, int capacity);
+int table_next_row(song_table_t *table);
+int table_read_row(song_table_t *table, int row, csv_field_t *fields, int num_fields);
+void table_append(song_table_t *table, song_table_t *other);
+void table_free(song_table_t *table);
+int compare_titles(song_table_t *table, int song1, int song2);
+ranks_before_t song_ranking(const char *required_column);
+void sort_songs(song_table_t *table, int *order, int count, ranks_before_t ranks_before);
+void radix_sort_songs(song_table_t *table, int *order, int count, ranks_before_t ranks_before);
+int merge_songs(song_table_t *table, int **runs, int *lengths, int num_runs, ranks_before_t ranks_before,
+                int *order, int limit);
+
+#endif
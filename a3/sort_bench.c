@@ -0,0 +1,217 @@
+/** @file sort_bench.c
+ *  @brief A benchmark of the song comparators on comparison-bound workloads.
+ *
+ * Every song of the given file is loaded into a song table, then the table is
+ * sorted by each column and the sorted runs of several chunks are k-way merged,
+ * the way music_manager does it with --sortMode=full. Each workload is timed once
+ * with a comparator that looks the column up by name on every comparison (the
+ * way compare_songs() used to) and once with the comparator from song_ranking();
+ * the best of several runs is reported and both orders are checked to match.
+ * Finally, the comparison sort is timed against radix_sort_songs().
+ *
+ * Usage: ./sort_bench FILE [RUNS]
+ *
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "csv.h"
+#include "emalloc.h"
+#include "song_table.h"
+
+/**
+ * @brief The number of chunks merged by the merge workload.
+ */
+#define NUM_RUNS 8
+
+/**
+ * @brief The column looked up by ranks_before_by_name().
+ */
+static const char *column;
+
+/**
+ * @brief Get the current time in seconds from a monotonic clock.
+ */
+static double now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/**
+ * @brief The comparator as it used to be: the column name is compared on every call.
+ */
+static int ranks_before_by_name(song_table_t *table, int song1, int song2)
+{
+    double result = 0;
+
+    if (strcmp(column, "popularity") == 0)
+    {
+        result = table->popularity[song1] - table->popularity[song2];
+    }
+    else if (strcmp(column, "energy") == 0)
+    {
+        result = table->energy[song1] - table->energy[song2];
+    }
+    else if (strcmp(column, "danceability") == 0)
+    {
+        result = table->danceability[song1] - table->danceability[song2];
+    }
+    if (result == 0)
+    {
+        result = compare_titles(table, song1, song2);
+    }
+    if (result != 0)
+    {
+        return result > 0;
+    }
+    return table->artist[song1] > table->artist[song2];
+}
+
+/**
+ * @brief Load every song of the file into a new table.
+ */
+static song_table_t *load_table(csv_file_t *csv)
+{
+    song_table_t *table = table_create(csv->data, 1024);
+    csv_field_t fields[NUM_FIELDS];
+    int num_fields;
+
+    csv_next_row(csv, fields, NUM_FIELDS, &num_fields);
+    while (csv_next_row(csv, fields, NUM_FIELDS, &num_fields)) {
+        if (table_read_row(table, table_next_row(table), fields, num_fields)) {
+            table->count++;
+        }
+    }
+    return table;
+}
+
+/**
+ * @brief Sort all rows of the table into `order`.
+ */
+static void run_sort(song_table_t *table, ranks_before_t ranks_before, int *order)
+{
+    for (int i = 0; i < table->count; i++) {
+        order[i] = i;
+    }
+    sort_songs(table, order, table->count, ranks_before);
+}
+
+/**
+ * @brief Radix sort all rows of the table into `order`.
+ */
+static void run_radix(song_table_t *table, ranks_before_t ranks_before, int *order)
+{
+    for (int i = 0; i < table->count; i++) {
+        order[i] = i;
+    }
+    radix_sort_songs(table, order, table->count, ranks_before);
+}
+
+/**
+ * @brief Sort NUM_RUNS chunks of the table separately, then merge them into `order`.
+ */
+static void run_merge(song_table_t *table, ranks_before_t ranks_before, int *order)
+{
+    int *chunks = (int *)emalloc(((size_t)table->count + 1) * sizeof(int));
+    int *runs[NUM_RUNS];
+    int lengths[NUM_RUNS];
+
+    for (int i = 0; i < NUM_RUNS; i++) {
+        int from = (int)((long)table->count * i / NUM_RUNS);
+        int to = (int)((long)table->count * (i + 1) / NUM_RUNS);
+        for (int j = from; j < to; j++) {
+            chunks[j] = j;
+        }
+        sort_songs(table, chunks + from, to - from, ranks_before);
+        runs[i] = chunks + from;
+        lengths[i] = to - from;
+    }
+    merge_songs(table, runs, lengths, NUM_RUNS, ranks_before, order, table->count);
+    free(chunks);
+}
+
+/**
+ * @brief Time the best of `runs` runs of a workload and store its order in `order`.
+ */
+static double bench(void (*run)(song_table_t *, ranks_before_t, int *), song_table_t *table,
+                    ranks_before_t ranks_before, int *order, int runs)
+{
+    double best = -1;
+
+    for (int i = 0; i < runs; i++) {
+        double start = now();
+        run(table, ranks_before, order);
+        double elapsed = now() - start;
+        if (best < 0 || elapsed < best) {
+            best = elapsed;
+        }
+    }
+    return best;
+}
+
+/**
+ * @brief The main function and entry point of the benchmark.
+ *
+ * @param argc The number of arguments passed to the program.
+ * @param argv The list of arguments passed to the program.
+ * @return int 0: No errors; 1: Errors produced.
+ *
+ */
+int main(int argc, char *argv[])
+{
+    static const char *columns[] = {"popularity", "energy", "danceability"};
+    static const char *workloads[] = {"sort", "merge"};
+    void (*runners[])(song_table_t *, ranks_before_t, int *) = {run_sort, run_merge};
+
+    if (argc < 2) {
+        fprintf(stderr, "usage: %s FILE [RUNS]\n", argv[0]);
+        return 1;
+    }
+    int runs = argc > 2 ? atoi(argv[2]) : 5;
+
+    csv_file_t *csv = csv_open(argv[1]);
+    if (csv == NULL) {
+        fprintf(stderr, "unable to open %s\n", argv[1]);
+        return 1;
+    }
+    song_table_t *table = load_table(csv);
+    int *expected = (int *)emalloc(((size_t)table->count + 1) * sizeof(int));
+    int *found = (int *)emalloc(((size_t)table->count + 1) * sizeof(int));
+    int ok = 1;
+
+    printf("%d rows\n", table->count);
+    for (int w = 0; w < 2; w++) {
+        for (int c = 0; c < 3; c++) {
+            column = columns[c];
+            double old = bench(runners[w], table, ranks_before_by_name, expected, runs);
+            double new = bench(runners[w], table, song_ranking(column), found, runs);
+            if (memcmp(expected, found, table->count * sizeof(int)) != 0) {
+                printf("%s by %s: the orders differ\n", workloads[w], column);
+                ok = 0;
+            }
+            printf("%-5s %-12s  by name %8.2f ms  precompiled %8.2f ms  speedup %5.2fx\n",
+                   workloads[w], column, old * 1e3, new * 1e3, old / new);
+        }
+    }
+    for (int c = 0; c < 3; c++) {
+        column = columns[c];
+        double old = bench(run_sort, table, song_ranking(column), expected, runs);
+        double new = bench(run_radix, table, song_ranking(column), found, runs);
+        if (memcmp(expected, found, table->count * sizeof(int)) != 0) {
+            printf("radix by %s: the orders differ\n", column);
+            ok = 0;
+        }
+        printf("radix %-12s  merge   %8.2f ms  radix       %8.2f ms  speedup %5.2fx\n",
+               column, old * 1e3, new * 1e3, old / new);
+    }
+
+    free(expected);
+    free(found);
+    table_free(table);
+    csv_close(csv);
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,210 @@
+/** @file topk.c
+ *  @brief Implementation of a bounded top-K song selector.
+ *
+ * Songs are kept in a binary min-heap of at most `k` rows keyed on the
+ * required column (with the comparator from song_ranking()), so a whole
+ * file can be streamed through it using O(k) memory.
+ *
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "emalloc.h"
+#include "song_table.h"
+#include "topk.h"
+
+/**
+ * @brief Move the row at heap index `i` up until its parent ranks below it.
+ */
+static void sift_up(topk_t *heap, int i)
+{
+    int row = heap->rows[i];
+
+    while (i > 0)
+    {
+        int parent = (i - 1) / 2;
+        if (!heap->ranks_before(heap->table, heap->rows[parent], row))
+        {
+            break;
+        }
+        heap->rows[i] = heap->rows[parent];
+        i = parent;
+    }
+    heap->rows[i] = row;
+}
+
+/**
+ * @brief Move the row at heap index `i` down until both children rank above it.
+ */
+static void sift_down(topk_t *heap, int i)
+{
+    int row = heap->rows[i];
+
+    for (;;)
+    {
+        int child = 2 * i + 1;
+        if (child >= heap->size)
+        {
+            break;
+        }
+        if (child + 1 < heap->size &&
+            heap->ranks_before(heap->table, heap->rows[child], heap->rows[child + 1]))
+        {
+            child++;
+        }
+        if (!heap->ranks_before(heap->table, row, heap->rows[child]))
+        {
+            break;
+        }
+        heap->rows[i] = heap->rows[child];
+        i = child;
+    }
+    heap->rows[i] = row;
+}
+
+/**
+ * @brief Double the room for row indices in the heap, up to `k` of them.
+ */
+static void grow_rows(topk_t *heap)
+{
+    size_t capacity = 2 * (size_t)heap->rows_capacity;
+    int *rows;
+
+    if (capacity > (size_t)heap->k)
+    {
+        capacity = heap->k;
+    }
+    rows = (int *)emalloc(capacity * sizeof(int));
+    memcpy(rows, heap->rows, heap->size * sizeof(int));
+    free(heap->rows);
+    heap->rows = rows;
+    heap->rows_capacity = (int)capacity;
+}
+
+/**
+ * Function:  topk_create
+ * ----------------------
+ * @brief  Allows to create an empty top-K selector.
+ *
+ * The table and the heap grow on demand up to `k + 1` rows, so a large `k`
+ * over a small file does not reserve memory that is never used.
+ *
+ * @param k The maximum number of songs to keep.
+ * @param text The input file the songs are read from.
+ * @param ranks_before The comparator of the sort column (see song_ranking()).
+ *
+ * @return topk_t* A pointer to the new selector.
+ *
+ */
+topk_t *topk_create(int k, const char *text, ranks_before_t ranks_before)
+{
+    topk_t *heap = (topk_t *)emalloc(sizeof(topk_t));
+
+    heap->k = k < 0 ? 0 : k;
+    heap->table = table_create(text, heap->k < 64 ? heap->k + 1 : 64);
+    heap->rows_capacity = heap->k < 64 ? heap->k + 1 : 64;
+    heap->rows = (int *)emalloc(heap->rows_capacity * sizeof(int));
+    heap->size = 0;
+    heap->ranks_before = ranks_before;
+
+    /* with k == 0 nothing is ever kept, so every candidate goes to the scratch row */
+    heap->scratch = 0;
+    if (heap->k == 0)
+    {
+        heap->table->count = 1;
+    }
+
+    return heap;
+}
+
+/**
+ * Function:  topk_candidate
+ * -------------------------
+ * @brief  Allows to get the row of the selector's table the next song is parsed into.
+ *
+ * @param heap The top-K selector.
+ *
+ * @return int The row to fill in before calling topk_offer().
+ *
+ */
+int topk_candidate(topk_t *heap)
+{
+    if (heap->size < heap->k)
+    {
+        return table_next_row(heap->table);
+    }
+    return heap->scratch;
+}
+
+/**
+ * Function:  topk_offer
+ * ---------------------
+ * @brief  Allows to offer the song in the candidate row to the top-K selector.
+ *
+ * When the heap is full, the candidate replaces the root if it ranks above it,
+ * and the row of the evicted song becomes the new scratch row. Candidates are
+ * offered in file order, so a candidate wins ties against the root.
+ *
+ * @param heap The top-K selector.
+ *
+ */
+void topk_offer(topk_t *heap)
+{
+    if (heap->size < heap->k)
+    {
+        if (heap->size == heap->rows_capacity)
+        {
+            grow_rows(heap);
+        }
+        heap->rows[heap->size++] = heap->table->count++;
+        sift_up(heap, heap->size - 1);
+        if (heap->size == heap->k)
+        {
+            heap->scratch = table_next_row(heap->table);
+            heap->table->count++;
+        }
+        return;
+    }
+
+    if (heap->k == 0 || !heap->ranks_before(heap->table, heap->scratch, heap->rows[0]))
+    {
+        return;
+    }
+    int evicted = heap->rows[0];
+    heap->rows[0] = heap->scratch;
+    heap->scratch = evicted;
+    sift_down(heap, 0);
+}
+
+/**
+ * Function:  topk_finish
+ * ----------------------
+ * @brief  Allows to drain the selector into an order of its table and release the heap.
+ *
+ * @param heap The top-K selector. It is freed by this call.
+ * @param order Set to a new array of the kept rows in descending order. The caller frees it.
+ * @param count Set to the number of kept rows.
+ *
+ * @return song_table_t* The table the kept rows live in. The caller frees it.
+ *
+ */
+song_table_t *topk_finish(topk_t *heap, int **order, int *count)
+{
+    song_table_t *table = heap->table;
+    int *rows = heap->rows;
+
+    /* heap sort: the lowest ranked rows are popped to the back, leaving the best one first */
+    *count = heap->size;
+    while (heap->size > 1)
+    {
+        int last = rows[heap->size - 1];
+        rows[heap->size - 1] = rows[0];
+        rows[0] = last;
+        heap->size--;
+        sift_down(heap, 0);
+    }
+
+    *order = rows;
+    free(heap);
+    return table;
+}
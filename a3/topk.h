@@ -0,0 +1,37 @@
+/** @file topk.h
+ *  @brief Function prototypes for the bounded top-K song selector.
+ */
+#ifndef _TOPK_H_
+#define _TOPK_H_
+
+#include "song_table.h"
+
+/**
+ * @brief A binary min-heap that keeps the best `k` songs seen so far.
+ *
+ * The songs live in the selector's own song table, which never holds more than
+ * `k + 1` rows: the kept songs plus one scratch row the next candidate is parsed
+ * into. The heap holds row indices, in an array that grows along with the table;
+ * its root is always the lowest ranked song kept,
+ * so a new song only has to be compared against the root to know whether it makes
+ * it into the top `k`.
+ */
+typedef struct topk {
+    song_table_t *table;
+    int *rows;
+    int rows_capacity;
+    int size;
+    int k;
+    int scratch;
+    ranks_before_t ranks_before;
+} topk_t;
+
+/**
+ * Function protypes associated with the top-K selector.
+ */
+topk_t *topk_create(int k, const char *text, ranks_before_t ranks_before);
+int topk_candidate(topk_t *heap);
+void topk_offer(topk_t *heap);
+song_table_t *topk_finish(topk_t *heap, int **order, int *count);
+
+#endif